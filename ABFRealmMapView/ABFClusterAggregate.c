@@ -0,0 +1,165 @@
+//
+//  ABFClusterAggregate.c
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#include "ABFClusterAggregate.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+static size_t ABFClusterAggregateSlotIndex(uint64_t key,
+                                           size_t mask)
+{
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+/**
+ *  Moves the cells to a table of twice the capacity
+ */
+static bool ABFClusterAggregateTableGrow(ABFClusterAggregateTable *table)
+{
+    size_t newCapacity = table->capacity * 2;
+    
+    ABFClusterAggregate *newCells = calloc(newCapacity, sizeof(ABFClusterAggregate));
+    
+    if (!newCells) {
+        return false;
+    }
+    
+    size_t mask = newCapacity - 1;
+    
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->cells[i].count == 0) {
+            continue;
+        }
+        
+        size_t slot = ABFClusterAggregateSlotIndex(table->cells[i].key, mask);
+        
+        while (newCells[slot].count > 0) {
+            slot = (slot + 1) & mask;
+        }
+        
+        newCells[slot] = table->cells[i];
+    }
+    
+    free(table->cells);
+    
+    table->cells = newCells;
+    table->capacity = newCapacity;
+    
+    return true;
+}
+
+bool ABFClusterAggregateTableInit(ABFClusterAggregateTable *table,
+                                  size_t capacity)
+{
+    size_t powerOfTwo = 16;
+    
+    while (powerOfTwo < capacity) {
+        powerOfTwo *= 2;
+    }
+    
+    table->cells = calloc(powerOfTwo, sizeof(ABFClusterAggregate));
+    table->capacity = table->cells ? powerOfTwo : 0;
+    table->cellCount = 0;
+    
+    return table->cells != NULL;
+}
+
+void ABFClusterAggregateTableFree(ABFClusterAggregateTable *table)
+{
+    free(table->cells);
+    
+    table->cells = NULL;
+    table->capacity = 0;
+    table->cellCount = 0;
+}
+
+uint64_t ABFClusterAggregateKey(double x,
+                                double y,
+                                double scaleFactor)
+{
+    uint64_t column = (uint64_t)floor(x * scaleFactor);
+    uint64_t row = (uint64_t)floor(y * scaleFactor);
+    
+    return (column << 32) | (row & 0xFFFFFFFF);
+}
+
+ABFClusterAggregate *ABFClusterAggregateSlot(const ABFClusterAggregateTable *table,
+                                             uint64_t key)
+{
+    size_t mask = table->capacity - 1;
+    size_t slot = ABFClusterAggregateSlotIndex(key, mask);
+    
+    while (table->cells[slot].count > 0 &&
+           table->cells[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    
+    return &table->cells[slot];
+}
+
+bool ABFClusterAggregateAdd(ABFClusterAggregateTable *table,
+                            uint64_t key,
+                            size_t index,
+                            size_t layer,
+                            double latitude,
+                            double longitude)
+{
+    ABFClusterAggregate *aggregate = ABFClusterAggregateSlot(table, key);
+    
+    if (aggregate->count == 0) {
+        // Grow first, so a failure leaves the table as it was
+        if ((table->cellCount + 1) * 2 > table->capacity) {
+            if (!ABFClusterAggregateTableGrow(table)) {
+                return false;
+            }
+            
+            aggregate = ABFClusterAggregateSlot(table, key);
+        }
+        
+        aggregate->key = key;
+        aggregate->index = index;
+        aggregate->layer = layer;
+        
+        table->cellCount++;
+    }
+    
+    aggregate->count++;
+    aggregate->totalLatitude += latitude;
+    aggregate->totalLongitude += longitude;
+    
+    return true;
+}
+
+ABFClusterAggregate *ABFClusterAggregateMerge(ABFClusterAggregateTable *table,
+                                              const ABFClusterAggregate *aggregate)
+{
+    ABFClusterAggregate *merged = ABFClusterAggregateSlot(table, aggregate->key);
+    
+    if (merged->count == 0) {
+        if ((table->cellCount + 1) * 2 > table->capacity) {
+            if (!ABFClusterAggregateTableGrow(table)) {
+                return NULL;
+            }
+            
+            merged = ABFClusterAggregateSlot(table, aggregate->key);
+        }
+        
+        merged->key = aggregate->key;
+        merged->index = aggregate->index;
+        merged->layer = aggregate->layer;
+        
+        table->cellCount++;
+    }
+    
+    merged->count += aggregate->count;
+    merged->totalLatitude += aggregate->totalLatitude;
+    merged->totalLongitude += aggregate->totalLongitude;
+    
+    return merged;
+}
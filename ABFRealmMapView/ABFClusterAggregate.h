@@ -0,0 +1,144 @@
+//
+//  ABFClusterAggregate.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#ifndef ABFClusterAggregate_h
+#define ABFClusterAggregate_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  Running totals for one cell of the cluster grid, used when the members are not kept
+ */
+typedef struct {
+    /**
+     *  Key of the cell from ABFClusterAggregateKey
+     */
+    uint64_t key;
+    
+    /**
+     *  Number of objects in the cell, 0 for an empty slot
+     */
+    size_t count;
+    
+    /**
+     *  Index in the fetch results of the first object in the cell
+     */
+    size_t index;
+    
+    /**
+     *  Layer of the first object in the cell
+     */
+    size_t layer;
+    
+    double totalLatitude;
+    double totalLongitude;
+} ABFClusterAggregate;
+
+/**
+ *  Open addressing hash table of cells, kept at most half full.
+ *
+ *  Platform-neutral core of the aggregate-only clustering of ABFLocationFetchedResultsController: the cells are keyed by map point (the MKMapPoint projection), so it builds without MapKit.
+ */
+typedef struct {
+    /**
+     *  Slots of the table, empty slots have a count of 0
+     */
+    ABFClusterAggregate *cells;
+    
+    /**
+     *  Number of slots, a power of 2
+     */
+    size_t capacity;
+    
+    /**
+     *  Number of occupied slots
+     */
+    size_t cellCount;
+} ABFClusterAggregateTable;
+
+/**
+ *  Allocates the slots of a table
+ *
+ *  @param table    table to initialize
+ *  @param capacity minimum number of slots, rounded up to a power of 2
+ *
+ *  @return false if the allocation failed
+ */
+extern bool ABFClusterAggregateTableInit(ABFClusterAggregateTable *table,
+                                         size_t capacity);
+
+/**
+ *  Frees the slots of a table, safe to call on a table that failed to initialize
+ */
+extern void ABFClusterAggregateTableFree(ABFClusterAggregateTable *table);
+
+/**
+ *  Key of the grid cell containing a map point
+ *
+ *  @param x           map point x
+ *  @param y           map point y
+ *  @param scaleFactor cells per map point (zoom scale divided by the cluster size in pixels)
+ *
+ *  @return the column of the cell in the high 32 bits and the row in the low 32 bits
+ */
+extern uint64_t ABFClusterAggregateKey(double x,
+                                       double y,
+                                       double scaleFactor);
+
+/**
+ *  Looks up a cell
+ *
+ *  @param table table to search
+ *  @param key   key of the cell
+ *
+ *  @return the slot of the cell, or the empty slot it would be inserted in
+ */
+extern ABFClusterAggregate *ABFClusterAggregateSlot(const ABFClusterAggregateTable *table,
+                                                    uint64_t key);
+
+/**
+ *  Adds an object to its cell, inserting the cell if needed. The table grows before it is more than half full.
+ *
+ *  @param table     table to add to
+ *  @param key       key of the cell
+ *  @param index     index of the object in the fetch results
+ *  @param layer     layer of the object
+ *  @param latitude  latitude of the object
+ *  @param longitude longitude of the object
+ *
+ *  @return false if growing the table failed, the table is left unchanged
+ */
+extern bool ABFClusterAggregateAdd(ABFClusterAggregateTable *table,
+                                   uint64_t key,
+                                   size_t index,
+                                   size_t layer,
+                                   double latitude,
+                                   double longitude);
+
+/**
+ *  Adds the totals of a cell of another table (such as the table of one layer) to the cell with the same key, inserting it if needed.
+ *
+ *  @param table     table to merge into
+ *  @param aggregate occupied cell of the other table
+ *
+ *  @return the merged cell, or NULL if growing the table failed (the table is left unchanged)
+ */
+extern ABFClusterAggregate *ABFClusterAggregateMerge(ABFClusterAggregateTable *table,
+                                                     const ABFClusterAggregate *aggregate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ABFClusterAggregate_h */
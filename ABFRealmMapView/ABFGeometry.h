@@ -0,0 +1,106 @@
+//
+//  ABFGeometry.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+@import MapKit;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  Mean radius of the Earth in meters, used for the spherical distance of circle fetches
+ */
+extern const CLLocationDistance ABFEarthRadius;
+
+/**
+ *  Number of latitude bands the covering of a shape is split into by default
+ */
+extern const NSUInteger ABFDefaultCoveringBandCount;
+
+/**
+ *  Computes the covering of a circle: one coordinate region per latitude band, each as wide as the circle is within the band.
+ *
+ *  The regions contain every coordinate within the radius (with a small padding for the strict bounds of NSPredicateForCoordinateRegion) and over-fetch less than the bounding box of the circle as the band count grows. Bands that reach a pole inside the circle span all longitudes. A band count of 1 returns the bounding region of the circle.
+ *
+ *  @param center    center of the circle
+ *  @param radius    radius in meters on a sphere of ABFEarthRadius
+ *  @param bandCount number of latitude bands, at least 1
+ *  @param regions   array with room for bandCount regions that receives the covering
+ *
+ *  @return the number of regions written
+ */
+extern NSUInteger ABFCoveringRegionsForCircle(CLLocationCoordinate2D center,
+                                              CLLocationDistance radius,
+                                              NSUInteger bandCount,
+                                              MKCoordinateRegion *regions);
+
+/**
+ *  Computes the covering of a polygon: one coordinate region per latitude band that contains the part of the polygon within the band.
+ *
+ *  Polygon edges are straight lines in latitude/longitude. A band count of 1 returns the bounding region of the polygon.
+ *
+ *  @param vertices    vertices of the polygon's outer ring, unwrapped with ABFUnwrapLongitudes
+ *  @param vertexCount number of vertices
+ *  @param bandCount   number of latitude bands, at least 1
+ *  @param regions     array with room for bandCount regions that receives the covering
+ *
+ *  @return the number of regions written
+ */
+extern NSUInteger ABFCoveringRegionsForPolygon(const CLLocationCoordinate2D *vertices,
+                                               NSUInteger vertexCount,
+                                               NSUInteger bandCount,
+                                               MKCoordinateRegion *regions);
+
+/**
+ *  Shifts longitudes by multiples of 360 so consecutive coordinates are never more than 180 degrees apart.
+ *
+ *  A polygon that crosses the -180/180 longitude meridian then has continuous longitudes (e.g. 170 to 190), so its edges do not wrap around the globe. The first coordinate is shifted to within 180 degrees of the reference longitude, which keeps the interior rings of a polygon in the frame of its outer ring.
+ *
+ *  @param coordinates        coordinates to unwrap in place
+ *  @param count              number of coordinates
+ *  @param referenceLongitude longitude the first coordinate is unwrapped against
+ */
+extern void ABFUnwrapLongitudes(CLLocationCoordinate2D *coordinates,
+                                NSUInteger count,
+                                CLLocationDegrees referenceLongitude);
+
+/**
+ *  Tests which coordinates are within the radius of the circle's center.
+ *
+ *  The great-circle distance is compared with the haversine formula, computed over batches of coordinates by ABFGeoCircleContainsPoints so the arithmetic vectorizes.
+ *
+ *  @param center      center of the circle
+ *  @param radius      radius in meters on a sphere of ABFEarthRadius
+ *  @param coordinates coordinates to test
+ *  @param count       number of coordinates
+ *  @param results     array with room for count values that receives YES for the coordinates in the circle
+ */
+extern void ABFCircleContainsCoordinates(CLLocationCoordinate2D center,
+                                         CLLocationDistance radius,
+                                         const CLLocationCoordinate2D *coordinates,
+                                         NSUInteger count,
+                                         BOOL *results);
+
+/**
+ *  Tests which coordinates are inside the polygon, with the even-odd rule so interior rings are holes.
+ *
+ *  The coordinates are wrapped into the longitude frame of the outer ring, so polygons that cross the -180/180 longitude meridian contain the coordinates on both sides of it. The edge crossings are computed one edge at a time over a batch of coordinates, without branches, so the inner loop vectorizes.
+ *
+ *  @param vertices    the vertices of all rings, outer ring first, unwrapped with ABFUnwrapLongitudes
+ *  @param ringCounts  number of vertices of each ring
+ *  @param ringCount   number of rings
+ *  @param coordinates coordinates to test
+ *  @param count       number of coordinates
+ *  @param results     array with room for count values that receives YES for the coordinates in the polygon
+ */
+extern void ABFPolygonContainsCoordinates(const CLLocationCoordinate2D *vertices,
+                                          const NSUInteger *ringCounts,
+                                          NSUInteger ringCount,
+                                          const CLLocationCoordinate2D *coordinates,
+                                          NSUInteger count,
+                                          BOOL *results);
+
+NS_ASSUME_NONNULL_END
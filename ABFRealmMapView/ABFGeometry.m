@@ -0,0 +1,81 @@
+//
+//  ABFGeometry.m
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#import "ABFGeometry.h"
+#import "ABFGeometryKernels.h"
+
+#pragma mark - Constants
+
+const CLLocationDistance ABFEarthRadius = 6371008.8;
+
+const NSUInteger ABFDefaultCoveringBandCount = 4;
+
+#pragma mark - Public Functions
+
+NSUInteger ABFCoveringRegionsForCircle(CLLocationCoordinate2D center,
+                                       CLLocationDistance radius,
+                                       NSUInteger bandCount,
+                                       MKCoordinateRegion *regions)
+{
+    double angularRadius = MIN(MAX(radius, 0) / ABFEarthRadius, M_PI);
+    
+    // ABFGeoRegion has the layout of MKCoordinateRegion
+    return ABFGeoCoveringRegionsForCircle((ABFGeoPoint){center.latitude, center.longitude},
+                                          angularRadius,
+                                          bandCount,
+                                          (ABFGeoRegion *)regions);
+}
+
+NSUInteger ABFCoveringRegionsForPolygon(const CLLocationCoordinate2D *vertices,
+                                        NSUInteger vertexCount,
+                                        NSUInteger bandCount,
+                                        MKCoordinateRegion *regions)
+{
+    return ABFGeoCoveringRegionsForPolygon((const ABFGeoPoint *)vertices,
+                                           vertexCount,
+                                           bandCount,
+                                           (ABFGeoRegion *)regions);
+}
+
+void ABFUnwrapLongitudes(CLLocationCoordinate2D *coordinates,
+                         NSUInteger count,
+                         CLLocationDegrees referenceLongitude)
+{
+    ABFGeoUnwrapLongitudes((ABFGeoPoint *)coordinates, count, referenceLongitude);
+}
+
+void ABFCircleContainsCoordinates(CLLocationCoordinate2D center,
+                                  CLLocationDistance radius,
+                                  const CLLocationCoordinate2D *coordinates,
+                                  NSUInteger count,
+                                  BOOL *results)
+{
+    double angularRadius = MIN(MAX(radius, 0) / ABFEarthRadius, M_PI);
+    
+    ABFGeoCircleContainsPoints((ABFGeoPoint){center.latitude, center.longitude},
+                               angularRadius,
+                               (const ABFGeoPoint *)coordinates,
+                               count,
+                               (uint8_t *)results);
+}
+
+void ABFPolygonContainsCoordinates(const CLLocationCoordinate2D *vertices,
+                                   const NSUInteger *ringCounts,
+                                   NSUInteger ringCount,
+                                   const CLLocationCoordinate2D *coordinates,
+                                   NSUInteger count,
+                                   BOOL *results)
+{
+    // NSUInteger is size_t and BOOL is a single byte on the platforms MapKit supports
+    ABFGeoPolygonContainsPoints((const ABFGeoPoint *)vertices,
+                                (const size_t *)ringCounts,
+                                ringCount,
+                                (const ABFGeoPoint *)coordinates,
+                                count,
+                                (uint8_t *)results);
+}
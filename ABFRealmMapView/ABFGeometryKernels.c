@@ -0,0 +1,344 @@
+//
+//  ABFGeometryKernels.c
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#include "ABFGeometryKernels.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#ifndef M_PI_2
+#define M_PI_2 1.57079632679489661923
+#endif
+
+/**
+ *  Number of points the kernels process at a time, sized for buffers on the stack
+ */
+#define ABFGeoBatchSize 256
+
+/**
+ *  Added to the covering regions (about 1cm) so the strict bounds of the predicate keep points on a band edge
+ */
+static const double ABFGeoCoveringPadding = 1e-7;
+
+static size_t ABFGeoMinSize(size_t a,
+                            size_t b)
+{
+    return a < b ? a : b;
+}
+
+static double ABFGeoRadiansForDegrees(double degrees)
+{
+    return degrees * M_PI / 180;
+}
+
+static double ABFGeoDegreesForRadians(double radians)
+{
+    return radians * 180 / M_PI;
+}
+
+/**
+ *  Half of the longitude span (in degrees) of a circle along a parallel, 180 if the whole parallel is inside the circle
+ */
+static double ABFGeoCircleHalfWidthAtLatitude(double centerLatitude,
+                                              double angularRadius,
+                                              double latitude)
+{
+    double cosProduct = cos(latitude) * cos(centerLatitude);
+    
+    if (cosProduct < 1e-12) {
+        return 180;
+    }
+    
+    // Spherical law of cosines solved for the longitude delta at the radius
+    double cosDelta = (cos(angularRadius) - sin(latitude) * sin(centerLatitude)) / cosProduct;
+    
+    if (cosDelta <= -1) {
+        return 180;
+    }
+    else if (cosDelta >= 1) {
+        return 0;
+    }
+    
+    return ABFGeoDegreesForRadians(acos(cosDelta));
+}
+
+static ABFGeoRegion ABFGeoRegionMake(double minLatitude,
+                                     double maxLatitude,
+                                     double centerLongitude,
+                                     double longitudeDelta)
+{
+    ABFGeoRegion region;
+    
+    region.center.latitude = (minLatitude + maxLatitude) / 2;
+    region.center.longitude = centerLongitude;
+    region.latitudeDelta = maxLatitude - minLatitude + 2 * ABFGeoCoveringPadding;
+    region.longitudeDelta = fmin(longitudeDelta + 2 * ABFGeoCoveringPadding, 360);
+    
+    return region;
+}
+
+double ABFGeoNormalizedLongitude(double longitude)
+{
+    return longitude - 360 * floor((longitude + 180) / 360);
+}
+
+void ABFGeoUnwrapLongitudes(ABFGeoPoint *points,
+                            size_t count,
+                            double referenceLongitude)
+{
+    double previousLongitude = referenceLongitude;
+    
+    for (size_t i = 0; i < count; i++) {
+        points[i].longitude = previousLongitude + ABFGeoNormalizedLongitude(points[i].longitude - previousLongitude);
+        
+        previousLongitude = points[i].longitude;
+    }
+}
+
+size_t ABFGeoCoveringRegionsForCircle(ABFGeoPoint center,
+                                      double angularRadius,
+                                      size_t bandCount,
+                                      ABFGeoRegion *regions)
+{
+    bandCount = bandCount > 0 ? bandCount : 1;
+    
+    angularRadius = fmin(fmax(angularRadius, 0), M_PI);
+    
+    double centerLatitude = ABFGeoRadiansForDegrees(center.latitude);
+    
+    double minLatitude = fmax(centerLatitude - angularRadius, -M_PI_2);
+    double maxLatitude = fmin(centerLatitude + angularRadius, M_PI_2);
+    
+    // The circle is widest at this latitude unless it contains a pole, then it widens towards the pole
+    double widestLatitude = NAN;
+    
+    double cosRadius = cos(angularRadius);
+    
+    if (cosRadius > fabs(sin(centerLatitude))) {
+        widestLatitude = asin(sin(centerLatitude) / cosRadius);
+    }
+    
+    double bandHeight = (maxLatitude - minLatitude) / bandCount;
+    
+    double centerLongitude = ABFGeoNormalizedLongitude(center.longitude);
+    
+    for (size_t band = 0; band < bandCount; band++) {
+        double bandMinLatitude = minLatitude + band * bandHeight;
+        double bandMaxLatitude = (band == bandCount - 1) ? maxLatitude : bandMinLatitude + bandHeight;
+        
+        // The width only has a maximum inside the band at the widest latitude, otherwise it is at an edge
+        double halfWidth = fmax(ABFGeoCircleHalfWidthAtLatitude(centerLatitude, angularRadius, bandMinLatitude),
+                                ABFGeoCircleHalfWidthAtLatitude(centerLatitude, angularRadius, bandMaxLatitude));
+        
+        if (widestLatitude > bandMinLatitude &&
+            widestLatitude < bandMaxLatitude) {
+            halfWidth = fmax(halfWidth, ABFGeoCircleHalfWidthAtLatitude(centerLatitude, angularRadius, widestLatitude));
+        }
+        
+        regions[band] = ABFGeoRegionMake(ABFGeoDegreesForRadians(bandMinLatitude),
+                                         ABFGeoDegreesForRadians(bandMaxLatitude),
+                                         centerLongitude,
+                                         2 * halfWidth);
+    }
+    
+    return bandCount;
+}
+
+size_t ABFGeoCoveringRegionsForPolygon(const ABFGeoPoint *vertices,
+                                       size_t vertexCount,
+                                       size_t bandCount,
+                                       ABFGeoRegion *regions)
+{
+    if (vertexCount == 0) {
+        return 0;
+    }
+    
+    bandCount = bandCount > 0 ? bandCount : 1;
+    
+    double minLatitude = vertices[0].latitude;
+    double maxLatitude = vertices[0].latitude;
+    
+    for (size_t i = 1; i < vertexCount; i++) {
+        minLatitude = fmin(minLatitude, vertices[i].latitude);
+        maxLatitude = fmax(maxLatitude, vertices[i].latitude);
+    }
+    
+    double bandHeight = (maxLatitude - minLatitude) / bandCount;
+    
+    size_t regionCount = 0;
+    
+    for (size_t band = 0; band < bandCount; band++) {
+        double bandMinLatitude = minLatitude + band * bandHeight;
+        double bandMaxLatitude = (band == bandCount - 1) ? maxLatitude : bandMinLatitude + bandHeight;
+        
+        double minLongitude = INFINITY;
+        double maxLongitude = -INFINITY;
+        
+        // The part of the polygon in the band is bounded by its edges clipped to the band
+        for (size_t i = 0; i < vertexCount; i++) {
+            ABFGeoPoint start = vertices[i];
+            ABFGeoPoint end = vertices[(i + 1) % vertexCount];
+            
+            double edgeMinLatitude = fmin(start.latitude, end.latitude);
+            double edgeMaxLatitude = fmax(start.latitude, end.latitude);
+            
+            if (edgeMaxLatitude < bandMinLatitude ||
+                edgeMinLatitude > bandMaxLatitude) {
+                continue;
+            }
+            
+            double startLongitude = start.longitude;
+            double endLongitude = end.longitude;
+            
+            if (edgeMaxLatitude > edgeMinLatitude) {
+                // Longitude is linear along the edge
+                double slope = (end.longitude - start.longitude) / (end.latitude - start.latitude);
+                
+                startLongitude = start.longitude + (fmax(edgeMinLatitude, bandMinLatitude) - start.latitude) * slope;
+                endLongitude = start.longitude + (fmin(edgeMaxLatitude, bandMaxLatitude) - start.latitude) * slope;
+            }
+            
+            minLongitude = fmin(minLongitude, fmin(startLongitude, endLongitude));
+            maxLongitude = fmax(maxLongitude, fmax(startLongitude, endLongitude));
+        }
+        
+        if (minLongitude > maxLongitude) {
+            continue;
+        }
+        
+        regions[regionCount] = ABFGeoRegionMake(bandMinLatitude,
+                                                bandMaxLatitude,
+                                                ABFGeoNormalizedLongitude((minLongitude + maxLongitude) / 2),
+                                                maxLongitude - minLongitude);
+        
+        regionCount++;
+    }
+    
+    return regionCount;
+}
+
+void ABFGeoCircleContainsPoints(ABFGeoPoint center,
+                                double angularRadius,
+                                const ABFGeoPoint *points,
+                                size_t count,
+                                uint8_t *results)
+{
+    // Haversine: inside when sin²(Δφ/2) + cos φc cos φ sin²(Δλ/2) <= sin²(r/2), no inverse trig needed
+    double threshold = sin(angularRadius / 2);
+    threshold *= threshold;
+    
+    double cosCenterLatitude = cos(center.latitude * M_PI / 180);
+    
+    double radians = M_PI / 180;
+    double halfRadians = M_PI / 360;
+    
+    double cosLatitudes[ABFGeoBatchSize];
+    double halfLatitudeDeltas[ABFGeoBatchSize];
+    double halfLongitudeDeltas[ABFGeoBatchSize];
+    
+    for (size_t batchStart = 0; batchStart < count; batchStart += ABFGeoBatchSize) {
+        size_t batchCount = ABFGeoMinSize(ABFGeoBatchSize, count - batchStart);
+        
+        const ABFGeoPoint *batch = &points[batchStart];
+        
+        for (size_t i = 0; i < batchCount; i++) {
+            cosLatitudes[i] = cos(batch[i].latitude * radians);
+        }
+        
+        for (size_t i = 0; i < batchCount; i++) {
+            halfLatitudeDeltas[i] = sin((batch[i].latitude - center.latitude) * halfRadians);
+        }
+        
+        for (size_t i = 0; i < batchCount; i++) {
+            halfLongitudeDeltas[i] = sin((batch[i].longitude - center.longitude) * halfRadians);
+        }
+        
+        for (size_t i = 0; i < batchCount; i++) {
+            double haversine = (halfLatitudeDeltas[i] * halfLatitudeDeltas[i] +
+                                cosCenterLatitude * cosLatitudes[i] * halfLongitudeDeltas[i] * halfLongitudeDeltas[i]);
+            
+            results[batchStart + i] = haversine <= threshold;
+        }
+    }
+}
+
+void ABFGeoPolygonContainsPoints(const ABFGeoPoint *vertices,
+                                 const size_t *ringCounts,
+                                 size_t ringCount,
+                                 const ABFGeoPoint *points,
+                                 size_t count,
+                                 uint8_t *results)
+{
+    if (ringCount == 0 ||
+        ringCounts[0] == 0) {
+        memset(results, 0, count);
+        
+        return;
+    }
+    
+    // Points are wrapped to within 180 degrees of the middle of the outer ring
+    double minLongitude = vertices[0].longitude;
+    double maxLongitude = vertices[0].longitude;
+    
+    for (size_t i = 1; i < ringCounts[0]; i++) {
+        minLongitude = fmin(minLongitude, vertices[i].longitude);
+        maxLongitude = fmax(maxLongitude, vertices[i].longitude);
+    }
+    
+    double referenceLongitude = (minLongitude + maxLongitude) / 2;
+    
+    double xs[ABFGeoBatchSize];
+    double ys[ABFGeoBatchSize];
+    uint8_t inside[ABFGeoBatchSize];
+    
+    for (size_t batchStart = 0; batchStart < count; batchStart += ABFGeoBatchSize) {
+        size_t batchCount = ABFGeoMinSize(ABFGeoBatchSize, count - batchStart);
+        
+        for (size_t i = 0; i < batchCount; i++) {
+            ABFGeoPoint point = points[batchStart + i];
+            
+            xs[i] = referenceLongitude + ABFGeoNormalizedLongitude(point.longitude - referenceLongitude);
+            ys[i] = point.latitude;
+        }
+        
+        memset(inside, 0, batchCount);
+        
+        size_t ringStart = 0;
+        
+        for (size_t ring = 0; ring < ringCount; ring++) {
+            size_t ringVertexCount = ringCounts[ring];
+            
+            for (size_t i = 0; i < ringVertexCount; i++) {
+                ABFGeoPoint start = vertices[ringStart + i];
+                ABFGeoPoint end = vertices[ringStart + (i + 1) % ringVertexCount];
+                
+                if (start.latitude == end.latitude) {
+                    continue;
+                }
+                
+                double slope = (end.longitude - start.longitude) / (end.latitude - start.latitude);
+                
+                // Crossing number: toggle the points whose eastward ray crosses the edge
+                for (size_t j = 0; j < batchCount; j++) {
+                    uint8_t straddles = (start.latitude > ys[j]) != (end.latitude > ys[j]);
+                    uint8_t west = xs[j] < start.longitude + (ys[j] - start.latitude) * slope;
+                    
+                    inside[j] ^= straddles & west;
+                }
+            }
+            
+            ringStart += ringVertexCount;
+        }
+        
+        memcpy(&results[batchStart], inside, batchCount);
+    }
+}
@@ -0,0 +1,132 @@
+//
+//  ABFGeometryKernels.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#ifndef ABFGeometryKernels_h
+#define ABFGeometryKernels_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  A latitude/longitude pair in degrees, with the same layout as CLLocationCoordinate2D.
+ *
+ *  Platform-neutral core of ABFGeometry: the coverings and containment tests take plain coordinates, so they build without MapKit.
+ */
+typedef struct {
+    double latitude;
+    double longitude;
+} ABFGeoPoint;
+
+/**
+ *  A region in degrees, with the same layout as MKCoordinateRegion
+ */
+typedef struct {
+    ABFGeoPoint center;
+    double latitudeDelta;
+    double longitudeDelta;
+} ABFGeoRegion;
+
+/**
+ *  Wraps a longitude into -180..<180
+ *
+ *  @param longitude longitude in degrees
+ *
+ *  @return the same meridian within -180..<180
+ */
+extern double ABFGeoNormalizedLongitude(double longitude);
+
+/**
+ *  Shifts longitudes by multiples of 360 so consecutive points are never more than 180 degrees apart. The first point is shifted to within 180 degrees of the reference longitude.
+ *
+ *  @param points             points to unwrap in place
+ *  @param count              number of points
+ *  @param referenceLongitude longitude the first point is unwrapped against
+ */
+extern void ABFGeoUnwrapLongitudes(ABFGeoPoint *points,
+                                   size_t count,
+                                   double referenceLongitude);
+
+/**
+ *  Computes the covering of a circle: one region per latitude band, each as wide as the circle is within the band.
+ *
+ *  The regions contain every point within the radius, padded by about 1cm for the strict bounds of NSPredicateForCoordinateRegion. Bands that reach a pole inside the circle span 360 degrees of longitude. A band count of 1 returns the bounding region of the circle.
+ *
+ *  @param center        center of the circle
+ *  @param angularRadius radius in radians (the distance divided by the sphere radius), 0...π
+ *  @param bandCount     number of latitude bands, values below 1 are treated as 1
+ *  @param regions       array with room for bandCount regions that receives the covering
+ *
+ *  @return the number of regions written
+ */
+extern size_t ABFGeoCoveringRegionsForCircle(ABFGeoPoint center,
+                                             double angularRadius,
+                                             size_t bandCount,
+                                             ABFGeoRegion *regions);
+
+/**
+ *  Computes the covering of a polygon: one region per latitude band that contains the part of the polygon within the band.
+ *
+ *  Polygon edges are straight lines in latitude/longitude. The regions are padded like those of ABFGeoCoveringRegionsForCircle, and bands without any edge are skipped. A band count of 1 returns the bounding region of the polygon.
+ *
+ *  @param vertices    vertices of the polygon's outer ring, unwrapped with ABFGeoUnwrapLongitudes
+ *  @param vertexCount number of vertices
+ *  @param bandCount   number of latitude bands, values below 1 are treated as 1
+ *  @param regions     array with room for bandCount regions that receives the covering
+ *
+ *  @return the number of regions written
+ */
+extern size_t ABFGeoCoveringRegionsForPolygon(const ABFGeoPoint *vertices,
+                                              size_t vertexCount,
+                                              size_t bandCount,
+                                              ABFGeoRegion *regions);
+
+/**
+ *  Tests which points are within an angular radius of a center with the haversine formula.
+ *
+ *  Points are processed in batches: the trigonometry of a batch is computed in separate loops, without branches, so the arithmetic vectorizes.
+ *
+ *  @param center        center of the circle
+ *  @param angularRadius radius in radians (the distance divided by the sphere radius), 0...π
+ *  @param points        points to test
+ *  @param count         number of points
+ *  @param results       array with room for count values that receives 1 for the points in the circle, 0 otherwise
+ */
+extern void ABFGeoCircleContainsPoints(ABFGeoPoint center,
+                                       double angularRadius,
+                                       const ABFGeoPoint *points,
+                                       size_t count,
+                                       uint8_t *results);
+
+/**
+ *  Tests which points are inside a polygon, with the even-odd rule so interior rings are holes.
+ *
+ *  Points are wrapped into the longitude frame of the outer ring. The edge crossings are computed one edge at a time over a batch of points, without branches, so the inner loop vectorizes.
+ *
+ *  @param vertices   the vertices of all rings, outer ring first, unwrapped with ABFGeoUnwrapLongitudes
+ *  @param ringCounts number of vertices of each ring
+ *  @param ringCount  number of rings
+ *  @param points     points to test
+ *  @param count      number of points
+ *  @param results    array with room for count values that receives 1 for the points in the polygon, 0 otherwise
+ */
+extern void ABFGeoPolygonContainsPoints(const ABFGeoPoint *vertices,
+                                        const size_t *ringCounts,
+                                        size_t ringCount,
+                                        const ABFGeoPoint *points,
+                                        size_t count,
+                                        uint8_t *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ABFGeometryKernels_h */
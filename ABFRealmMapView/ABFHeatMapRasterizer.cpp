@@ -0,0 +1,394 @@
+//
+//  ABFHeatMapRasterizer.cpp
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#include "ABFHeatMapRasterizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(ABF_HEATMAP_SCALAR)
+#define ABF_HEATMAP_VECTOR 1
+#else
+#define ABF_HEATMAP_VECTOR 0
+#endif
+
+namespace {
+
+#if ABF_HEATMAP_VECTOR
+typedef float ABFFloat4 __attribute__((vector_size(16)));
+
+static const size_t ABFFloat4Lanes = 4;
+
+inline ABFFloat4 ABFFloat4Load(const float *values)
+{
+    ABFFloat4 vector;
+    std::memcpy(&vector, values, sizeof(vector));
+    return vector;
+}
+
+inline void ABFFloat4Store(float *values, ABFFloat4 vector)
+{
+    std::memcpy(values, &vector, sizeof(vector));
+}
+
+inline ABFFloat4 ABFFloat4Splat(float value)
+{
+    ABFFloat4 vector = {value, value, value, value};
+    return vector;
+}
+#endif
+
+std::vector<float> ABFGaussianKernel(uint32_t radius)
+{
+    size_t size = 2 * radius + 1;
+    std::vector<float> kernel(size);
+    
+    float sigma = std::max(radius / 2.0f, 1.0f);
+    float sum = 0;
+    
+    for (size_t i = 0; i < size; i++) {
+        float x = (float)i - (float)radius;
+        kernel[i] = std::exp(-(x * x) / (2 * sigma * sigma));
+        sum += kernel[i];
+    }
+    
+    for (size_t i = 0; i < size; i++) {
+        kernel[i] /= sum;
+    }
+    
+    return kernel;
+}
+
+// Horizontal pass: each row of the input is convolved into a row of outputWidth values
+void ABFBlurRowsScalar(const float *input,
+                       size_t rows,
+                       size_t inputWidth,
+                       size_t outputWidth,
+                       const std::vector<float> &kernel,
+                       float *output)
+{
+    for (size_t row = 0; row < rows; row++) {
+        const float *in = input + row * inputWidth;
+        float *out = output + row * outputWidth;
+        
+        for (size_t x = 0; x < outputWidth; x++) {
+            float sum = 0;
+            
+            for (size_t k = 0; k < kernel.size(); k++) {
+                sum += kernel[k] * in[x + k];
+            }
+            
+            out[x] = sum;
+        }
+    }
+}
+
+// Vertical pass: each output row is the kernel-weighted sum of the input rows below it
+void ABFBlurColumnsScalar(const float *input,
+                          size_t width,
+                          size_t outputRows,
+                          const std::vector<float> &kernel,
+                          float *output)
+{
+    for (size_t row = 0; row < outputRows; row++) {
+        float *out = output + row * width;
+        std::fill(out, out + width, 0.0f);
+        
+        for (size_t k = 0; k < kernel.size(); k++) {
+            const float *in = input + (row + k) * width;
+            float weight = kernel[k];
+            
+            for (size_t x = 0; x < width; x++) {
+                out[x] += weight * in[x];
+            }
+        }
+    }
+}
+
+#if ABF_HEATMAP_VECTOR
+// Each output is summed over the kernel in the same order as the scalar passes, four independent
+// accumulators of four pixels hide the latency of the additions
+void ABFBlurRowsVector(const float *input,
+                       size_t rows,
+                       size_t inputWidth,
+                       size_t outputWidth,
+                       const std::vector<float> &kernel,
+                       float *output)
+{
+    const size_t blockWidth = 4 * ABFFloat4Lanes;
+    
+    for (size_t row = 0; row < rows; row++) {
+        const float *in = input + row * inputWidth;
+        float *out = output + row * outputWidth;
+        
+        size_t x = 0;
+        
+        for (; x + blockWidth <= outputWidth; x += blockWidth) {
+            ABFFloat4 sum0 = ABFFloat4Splat(0), sum1 = sum0, sum2 = sum0, sum3 = sum0;
+            
+            for (size_t k = 0; k < kernel.size(); k++) {
+                ABFFloat4 weight = ABFFloat4Splat(kernel[k]);
+                const float *values = in + x + k;
+                
+                sum0 += weight * ABFFloat4Load(values);
+                sum1 += weight * ABFFloat4Load(values + ABFFloat4Lanes);
+                sum2 += weight * ABFFloat4Load(values + 2 * ABFFloat4Lanes);
+                sum3 += weight * ABFFloat4Load(values + 3 * ABFFloat4Lanes);
+            }
+            
+            ABFFloat4Store(out + x, sum0);
+            ABFFloat4Store(out + x + ABFFloat4Lanes, sum1);
+            ABFFloat4Store(out + x + 2 * ABFFloat4Lanes, sum2);
+            ABFFloat4Store(out + x + 3 * ABFFloat4Lanes, sum3);
+        }
+        
+        for (; x + ABFFloat4Lanes <= outputWidth; x += ABFFloat4Lanes) {
+            ABFFloat4 sum = ABFFloat4Splat(0);
+            
+            for (size_t k = 0; k < kernel.size(); k++) {
+                sum += ABFFloat4Splat(kernel[k]) * ABFFloat4Load(in + x + k);
+            }
+            
+            ABFFloat4Store(out + x, sum);
+        }
+        
+        for (; x < outputWidth; x++) {
+            float sum = 0;
+            
+            for (size_t k = 0; k < kernel.size(); k++) {
+                sum += kernel[k] * in[x + k];
+            }
+            
+            out[x] = sum;
+        }
+    }
+}
+
+void ABFBlurColumnsVector(const float *input,
+                          size_t width,
+                          size_t outputRows,
+                          const std::vector<float> &kernel,
+                          float *output)
+{
+    const size_t blockWidth = 4 * ABFFloat4Lanes;
+    
+    for (size_t row = 0; row < outputRows; row++) {
+        float *out = output + row * width;
+        
+        size_t x = 0;
+        
+        for (; x + blockWidth <= width; x += blockWidth) {
+            ABFFloat4 sum0 = ABFFloat4Splat(0), sum1 = sum0, sum2 = sum0, sum3 = sum0;
+            
+            for (size_t k = 0; k < kernel.size(); k++) {
+                ABFFloat4 weight = ABFFloat4Splat(kernel[k]);
+                const float *values = input + (row + k) * width + x;
+                
+                sum0 += weight * ABFFloat4Load(values);
+                sum1 += weight * ABFFloat4Load(values + ABFFloat4Lanes);
+                sum2 += weight * ABFFloat4Load(values + 2 * ABFFloat4Lanes);
+                sum3 += weight * ABFFloat4Load(values + 3 * ABFFloat4Lanes);
+            }
+            
+            ABFFloat4Store(out + x, sum0);
+            ABFFloat4Store(out + x + ABFFloat4Lanes, sum1);
+            ABFFloat4Store(out + x + 2 * ABFFloat4Lanes, sum2);
+            ABFFloat4Store(out + x + 3 * ABFFloat4Lanes, sum3);
+        }
+        
+        for (; x + ABFFloat4Lanes <= width; x += ABFFloat4Lanes) {
+            ABFFloat4 sum = ABFFloat4Splat(0);
+            
+            for (size_t k = 0; k < kernel.size(); k++) {
+                sum += ABFFloat4Splat(kernel[k]) * ABFFloat4Load(input + (row + k) * width + x);
+            }
+            
+            ABFFloat4Store(out + x, sum);
+        }
+        
+        for (; x < width; x++) {
+            float sum = 0;
+            
+            for (size_t k = 0; k < kernel.size(); k++) {
+                sum += kernel[k] * input[(row + k) * width + x];
+            }
+            
+            out[x] = sum;
+        }
+    }
+}
+#endif
+
+} // namespace
+
+bool ABFHeatMapSIMDAvailable(void)
+{
+    return ABF_HEATMAP_VECTOR;
+}
+
+uint32_t ABFHeatMapGridPixels(const ABFHeatMapTileParameters *parameters)
+{
+    return parameters->tilePixels + 2 * parameters->radius;
+}
+
+void ABFHeatMapGradientTable(const float *colors,
+                             size_t colorCount,
+                             uint32_t *table)
+{
+    std::memset(table, 0, ABFHeatMapGradientSteps * sizeof(uint32_t));
+    
+    if (colorCount == 0) {
+        return;
+    }
+    
+    for (size_t i = 0; i < ABFHeatMapGradientSteps; i++) {
+        float intensity = (float)i / (ABFHeatMapGradientSteps - 1);
+        float position = intensity * (colorCount - 1);
+        
+        size_t lower = std::min((size_t)position, colorCount - 1);
+        size_t upper = std::min(lower + 1, colorCount - 1);
+        float fraction = position - lower;
+        
+        float components[4];
+        
+        for (size_t c = 0; c < 4; c++) {
+            components[c] = colors[lower * 4 + c] + (colors[upper * 4 + c] - colors[lower * 4 + c]) * fraction;
+        }
+        
+        float alpha = components[3] * intensity;
+        
+        uint8_t *pixel = (uint8_t *)(table + i);
+        pixel[0] = (uint8_t)std::lround(components[0] * alpha * 255);
+        pixel[1] = (uint8_t)std::lround(components[1] * alpha * 255);
+        pixel[2] = (uint8_t)std::lround(components[2] * alpha * 255);
+        pixel[3] = (uint8_t)std::lround(alpha * 255);
+    }
+}
+
+size_t ABFHeatMapBinPoints(const double *xs,
+                           const double *ys,
+                           size_t count,
+                           double originX,
+                           double originY,
+                           double worldWidth,
+                           double mapPointsPerPixel,
+                           uint32_t gridPixels,
+                           float *density)
+{
+    size_t binned = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        double dx = xs[i] - originX;
+        
+        // Tiles at the edges of the world pick up the points across the meridian
+        if (dx < 0) {
+            dx += worldWidth;
+        }
+        else if (dx >= worldWidth) {
+            dx -= worldWidth;
+        }
+        
+        double px = std::floor(dx / mapPointsPerPixel);
+        double py = std::floor((ys[i] - originY) / mapPointsPerPixel);
+        
+        if (px < 0 || py < 0 ||
+            px >= gridPixels || py >= gridPixels) {
+            continue;
+        }
+        
+        density[(size_t)py * gridPixels + (size_t)px] += 1;
+        binned++;
+    }
+    
+    return binned;
+}
+
+void ABFHeatMapRasterizeDensity(const ABFHeatMapTileParameters *parameters,
+                                const float *density,
+                                const uint32_t *gradientTable,
+                                uint32_t *pixels)
+{
+    size_t tilePixels = parameters->tilePixels;
+    size_t gridPixels = ABFHeatMapGridPixels(parameters);
+    
+    std::vector<float> kernel = ABFGaussianKernel(parameters->radius);
+    
+    // Rows are blurred to the tile width, then columns to the tile height, without a transpose
+    std::vector<float> horizontal(gridPixels * tilePixels);
+    std::vector<float> blurred(tilePixels * tilePixels);
+
+#if ABF_HEATMAP_VECTOR
+    if (parameters->useSIMD) {
+        ABFBlurRowsVector(density, gridPixels, gridPixels, tilePixels, kernel, horizontal.data());
+        ABFBlurColumnsVector(horizontal.data(), tilePixels, tilePixels, kernel, blurred.data());
+    }
+    else
+#endif
+    {
+        ABFBlurRowsScalar(density, gridPixels, gridPixels, tilePixels, kernel, horizontal.data());
+        ABFBlurColumnsScalar(horizontal.data(), tilePixels, tilePixels, kernel, blurred.data());
+    }
+    
+    // Logarithmic intensity, so sparse points stay visible next to dense clusters: the gradient index is
+    // floor(log1p(density) * scale), found by searching the densities where each index starts instead of a log per pixel
+    float saturation = std::max(parameters->saturationDensity, FLT_EPSILON);
+    float scale = (ABFHeatMapGradientSteps - 1) / std::log1p(saturation);
+    
+    float thresholds[ABFHeatMapGradientSteps];
+    thresholds[0] = -FLT_MAX;
+    
+    for (size_t i = 1; i < ABFHeatMapGradientSteps; i++) {
+        thresholds[i] = std::expm1(i / scale);
+    }
+    
+    // One search step over a whole row at a time, so the lookups of neighbouring pixels overlap
+    std::vector<uint8_t> indexes(tilePixels);
+    
+    for (size_t row = 0; row < tilePixels; row++) {
+        const float *values = blurred.data() + row * tilePixels;
+        
+        std::fill(indexes.begin(), indexes.end(), 0);
+        
+        for (size_t step = ABFHeatMapGradientSteps / 2; step > 0; step /= 2) {
+            for (size_t x = 0; x < tilePixels; x++) {
+                indexes[x] += (values[x] >= thresholds[indexes[x] + step]) ? step : 0;
+            }
+        }
+        
+        for (size_t x = 0; x < tilePixels; x++) {
+            pixels[row * tilePixels + x] = gradientTable[indexes[x]];
+        }
+    }
+}
+
+size_t ABFHeatMapRenderTile(const ABFHeatMapTileParameters *parameters,
+                            const double *xs,
+                            const double *ys,
+                            size_t count,
+                            double originX,
+                            double originY,
+                            double worldWidth,
+                            double mapPointsPerPixel,
+                            const uint32_t *gradientTable,
+                            uint32_t *pixels)
+{
+    uint32_t gridPixels = ABFHeatMapGridPixels(parameters);
+    
+    std::vector<float> density((size_t)gridPixels * gridPixels, 0.0f);
+    
+    size_t binned = ABFHeatMapBinPoints(xs, ys, count, originX, originY, worldWidth, mapPointsPerPixel, gridPixels, density.data());
+    
+    if (binned > 0) {
+        ABFHeatMapRasterizeDensity(parameters, density.data(), gradientTable, pixels);
+    }
+    
+    return binned;
+}
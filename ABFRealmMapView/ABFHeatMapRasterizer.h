@@ -0,0 +1,152 @@
+//
+//  ABFHeatMapRasterizer.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#ifndef ABFHeatMapRasterizer_h
+#define ABFHeatMapRasterizer_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  Number of entries in a heat map gradient table
+ */
+#define ABFHeatMapGradientSteps 256
+
+/**
+ *  Parameters for rasterizing one heat map tile
+ */
+typedef struct {
+    /**
+     *  Width and height of the tile in pixels
+     */
+    uint32_t tilePixels;
+    
+    /**
+     *  Radius in pixels of the Gaussian blur applied to each point
+     */
+    uint32_t radius;
+    
+    /**
+     *  Blurred density that maps to the last gradient color, intensity is scaled logarithmically up to it
+     */
+    float saturationDensity;
+    
+    /**
+     *  Use the vectorized blur when the compiler supports it, false forces the scalar fallback
+     */
+    bool useSIMD;
+} ABFHeatMapTileParameters;
+
+/**
+ *  Platform-neutral core of ABFHeatMapTileOverlay, written in C++ with a C interface.
+ *
+ *  Points are given in map points (the MKMapPoint projection). The blur uses GCC/Clang vector extensions (SSE on x86, NEON on ARM) with a scalar fallback when they are not available or when useSIMD is false.
+ *
+ *  @return YES if the vectorized blur was compiled in
+ */
+extern bool ABFHeatMapSIMDAvailable(void);
+
+/**
+ *  Size in pixels of the density grid for a tile: the tile plus the blur radius on each side
+ *
+ *  @param parameters tile parameters
+ *
+ *  @return width and height of the density grid
+ */
+extern uint32_t ABFHeatMapGridPixels(const ABFHeatMapTileParameters *parameters);
+
+/**
+ *  Builds a lookup table of premultiplied RGBA pixels, where the index is the intensity.
+ *
+ *  Colors are spread evenly from the lowest to the highest intensity and the alpha of each entry is scaled by its intensity, so index 0 is transparent.
+ *
+ *  @param colors     RGBA components (0...1) of each color, 4 floats per color
+ *  @param colorCount number of colors
+ *  @param table      array of ABFHeatMapGradientSteps pixels that receives the table
+ */
+extern void ABFHeatMapGradientTable(const float *colors,
+                                    size_t colorCount,
+                                    uint32_t *table);
+
+/**
+ *  Adds each point to the density grid pixel it falls in.
+ *
+ *  Points are wrapped across the -180/180 longitude meridian to the copy of the world nearest the grid.
+ *
+ *  @param xs                map point x of each point
+ *  @param ys                map point y of each point
+ *  @param count             number of points
+ *  @param originX           map point x of the top left of the grid
+ *  @param originY           map point y of the top left of the grid
+ *  @param worldWidth        width of the world in map points
+ *  @param mapPointsPerPixel map points covered by one pixel
+ *  @param gridPixels        width and height of the grid
+ *  @param density           grid of gridPixels * gridPixels values that the points are added to
+ *
+ *  @return the number of points inside the grid
+ */
+extern size_t ABFHeatMapBinPoints(const double *xs,
+                                  const double *ys,
+                                  size_t count,
+                                  double originX,
+                                  double originY,
+                                  double worldWidth,
+                                  double mapPointsPerPixel,
+                                  uint32_t gridPixels,
+                                  float *density);
+
+/**
+ *  Blurs a density grid with a separable Gaussian kernel and colors the tile with a gradient table.
+ *
+ *  @param parameters    tile parameters
+ *  @param density       grid of ABFHeatMapGridPixels * ABFHeatMapGridPixels values
+ *  @param gradientTable table from ABFHeatMapGradientTable
+ *  @param pixels        array of tilePixels * tilePixels premultiplied RGBA pixels that receives the tile
+ */
+extern void ABFHeatMapRasterizeDensity(const ABFHeatMapTileParameters *parameters,
+                                       const float *density,
+                                       const uint32_t *gradientTable,
+                                       uint32_t *pixels);
+
+/**
+ *  Bins the points into a density grid and rasterizes the tile.
+ *
+ *  @param parameters        tile parameters
+ *  @param xs                map point x of each point
+ *  @param ys                map point y of each point
+ *  @param count             number of points
+ *  @param originX           map point x of the top left of the density grid (the tile origin minus the blur radius)
+ *  @param originY           map point y of the top left of the density grid
+ *  @param worldWidth        width of the world in map points
+ *  @param mapPointsPerPixel map points covered by one pixel
+ *  @param gradientTable     table from ABFHeatMapGradientTable
+ *  @param pixels            array of tilePixels * tilePixels premultiplied RGBA pixels that receives the tile
+ *
+ *  @return the number of points that contributed to the tile, the pixels are left untouched if 0
+ */
+extern size_t ABFHeatMapRenderTile(const ABFHeatMapTileParameters *parameters,
+                                   const double *xs,
+                                   const double *ys,
+                                   size_t count,
+                                   double originX,
+                                   double originY,
+                                   double worldWidth,
+                                   double mapPointsPerPixel,
+                                   const uint32_t *gradientTable,
+                                   uint32_t *pixels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ABFHeatMapRasterizer_h */
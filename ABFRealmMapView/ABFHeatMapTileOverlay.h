@@ -0,0 +1,111 @@
+//
+//  ABFHeatMapTileOverlay.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+@import MapKit;
+
+#if __has_include(<RealmMapView/RealmMapView.h>)
+@import Realm;
+#else
+#import <Realm/Realm.h>
+#endif
+
+/**
+ *  Tile overlay that renders the density of Realm object locations as a heat map.
+ *
+ *  Each 256px tile is rasterized off the main thread: the objects within the tile (plus a margin for the blur radius) are fetched with a location predicate, binned into a per-pixel density grid, smoothed with a separable Gaussian kernel and colored with the gradient. Rendered tiles are kept in an in-memory least recently used cache until reloadTiles is called.
+ *
+ *  The rasterization runs in a platform-neutral C++ core (ABFHeatMapRasterizer) with a vectorized blur and a scalar fallback, which is tested on its own against golden images.
+ *
+ *  Display the overlay with MKTileOverlayRenderer. ABFRealmMapView manages an instance automatically when heatMap is enabled.
+ */
+@interface ABFHeatMapTileOverlay : MKTileOverlay
+
+/**
+ *  RLMObject class name for the objects to render
+ */
+@property (nonatomic, readonly, nonnull) NSString *entityName;
+
+/**
+ *  The configuration for the Realm in which the entity resides
+ */
+@property (nonatomic, readonly, nonnull) RLMRealmConfiguration *realmConfiguration;
+
+/**
+ *  Latitude key path on the Realm object for entityName
+ */
+@property (nonatomic, readonly, nonnull) NSString *latitudeKeyPath;
+
+/**
+ *  Longitude key path on the Realm object for entityName
+ */
+@property (nonatomic, readonly, nonnull) NSString *longitudeKeyPath;
+
+/**
+ *  Predicate that is included, via AND, along with the generated predicate for each tile's bounds.
+ *
+ *  Atomic, since tiles read it on the render queue.
+ *
+ *  @warning Call reloadTiles after changing to invalidate the tile cache.
+ */
+@property (atomic, strong, nullable) NSPredicate *basePredicate;
+
+/**
+ *  The radius in pixels of the Gaussian blur applied to the density of each point. Setting it calls reloadTiles.
+ *
+ *  Default is 12
+ */
+@property (nonatomic, assign) NSUInteger radius;
+
+/**
+ *  The blurred density value (roughly, the number of overlapping points) that maps to the hottest gradient color.
+ *
+ *  Intensity is scaled logarithmically up to this value. Setting it calls reloadTiles.
+ *
+ *  Default is 8
+ */
+@property (nonatomic, assign) double saturationDensity;
+
+/**
+ *  Colors spread evenly from the lowest to the highest intensity. The alpha of each rendered pixel is also scaled by its intensity. Setting it calls reloadTiles.
+ *
+ *  Default is blue, cyan, green, yellow, red
+ */
+@property (nonatomic, strong, nonnull) NSArray<UIColor *> *gradientColors;
+
+/**
+ *  The maximum number of rendered tiles kept in the cache. Once full, the least recently displayed tile is evicted first. 0 means no limit.
+ *
+ *  Default is 256
+ */
+@property (nonatomic, assign) NSUInteger tileCacheCountLimit;
+
+/**
+ *  Creates an instance of ABFHeatMapTileOverlay.
+ *
+ *  @param entityName       the Realm object name (class name)
+ *  @param realm            the RLMRealm in which the entity(s) exist
+ *  @param latitudeKeyPath  the key path on the Realm objects for the latitude value
+ *  @param longitudeKeyPath the key path on the Realm objects for the longitude value
+ *
+ *  @return instance of ABFHeatMapTileOverlay
+ */
+- (nonnull instancetype)initWithEntityName:(nonnull NSString *)entityName
+                                   inRealm:(nonnull RLMRealm *)realm
+                           latitudeKeyPath:(nonnull NSString *)latitudeKeyPath
+                          longitudeKeyPath:(nonnull NSString *)longitudeKeyPath;
+
+/**
+ *  Removes all rendered tiles from the cache so they are rasterized again on next display.
+ *
+ *  Tiles still waiting to render are cancelled, their loads finish with an NSUserCancelledError in NSCocoaErrorDomain. Tiles already rendering finish but are not cached.
+ *
+ *  @warning Call reloadData on the overlay renderer afterwards to redraw the visible tiles.
+ */
+- (void)reloadTiles;
+
+@end
@@ -0,0 +1,530 @@
+//
+//  ABFHeatMapTileOverlay.m
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#import "ABFHeatMapTileOverlay.h"
+#import "ABFLocationFetchRequest.h"
+#import "ABFHeatMapRasterizer.h"
+
+static NSString * const ABFHeatMapTileOverlayErrorDomain = @"ABFHeatMapTileOverlayErrorDomain";
+
+#pragma mark - Private Functions
+
+/**
+ *  Builds a lookup table of premultiplied RGBA pixels, where the index is the intensity
+ */
+static NSData *ABFGradientTableForColors(NSArray<UIColor *> *colors)
+{
+    NSMutableData *componentData = [NSMutableData dataWithLength:colors.count * 4 * sizeof(float)];
+    float *components = componentData.mutableBytes;
+    
+    for (NSUInteger i = 0; i < colors.count; i++) {
+        CGFloat r = 0, g = 0, b = 0, a = 0;
+        
+        [colors[i] getRed:&r green:&g blue:&b alpha:&a];
+        
+        components[i * 4] = r;
+        components[i * 4 + 1] = g;
+        components[i * 4 + 2] = b;
+        components[i * 4 + 3] = a;
+    }
+    
+    NSMutableData *tableData = [NSMutableData dataWithLength:ABFHeatMapGradientSteps * sizeof(uint32_t)];
+    
+    ABFHeatMapGradientTable(components, colors.count, tableData.mutableBytes);
+    
+    return tableData.copy;
+}
+
+#pragma mark - ABFHeatMapTileCache
+
+/**
+ *  Entry of ABFHeatMapTileCache, linked from the most to the least recently used
+ */
+@interface ABFHeatMapTileCacheEntry : NSObject
+
+@property (nonatomic, strong) NSString *key;
+
+@property (nonatomic, strong) NSData *tile;
+
+@property (nonatomic, weak) ABFHeatMapTileCacheEntry *previous;
+
+@property (nonatomic, strong) ABFHeatMapTileCacheEntry *next;
+
+@end
+
+@implementation ABFHeatMapTileCacheEntry
+
+@end
+
+/**
+ *  Thread-safe cache of rendered tiles that evicts the least recently used tile once it holds countLimit tiles.
+ *
+ *  Unlike NSCache, the eviction order is deterministic: the tiles panned away from the longest are rasterized again first.
+ */
+@interface ABFHeatMapTileCache : NSObject
+
+@property (nonatomic, assign) NSUInteger countLimit;
+
+/**
+ *  Incremented by removeAllObjects, so renders started before can't cache their tiles afterwards
+ */
+@property (atomic, readonly) NSUInteger generation;
+
+- (NSData *)objectForKey:(NSString *)key;
+
+/**
+ *  Caches the tile unless the cache was emptied since the render of the tile started
+ *
+ *  @param tile       rendered tile
+ *  @param key        key of the tile
+ *  @param generation generation of the cache when the render started
+ */
+- (void)setObject:(NSData *)tile forKey:(NSString *)key generation:(NSUInteger)generation;
+
+- (void)removeAllObjects;
+
+@end
+
+@interface ABFHeatMapTileCache ()
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, ABFHeatMapTileCacheEntry *> *entries;
+
+@property (nonatomic, strong) ABFHeatMapTileCacheEntry *mostRecentlyUsed;
+
+@property (nonatomic, weak) ABFHeatMapTileCacheEntry *leastRecentlyUsed;
+
+@end
+
+@implementation ABFHeatMapTileCache
+
+- (instancetype)init
+{
+    self = [super init];
+    
+    if (self) {
+        _entries = [NSMutableDictionary dictionary];
+    }
+    
+    return self;
+}
+
+- (NSData *)objectForKey:(NSString *)key
+{
+    @synchronized(self) {
+        ABFHeatMapTileCacheEntry *entry = self.entries[key];
+        
+        if (entry) {
+            [self unlinkEntry:entry];
+            [self linkEntry:entry];
+        }
+        
+        return entry.tile;
+    }
+}
+
+- (void)setObject:(NSData *)tile forKey:(NSString *)key generation:(NSUInteger)generation
+{
+    @synchronized(self) {
+        if (generation != _generation) {
+            return;
+        }
+        
+        ABFHeatMapTileCacheEntry *entry = self.entries[key];
+        
+        if (entry) {
+            [self unlinkEntry:entry];
+        }
+        else {
+            entry = [[ABFHeatMapTileCacheEntry alloc] init];
+            entry.key = key;
+            
+            self.entries[key] = entry;
+        }
+        
+        entry.tile = tile;
+        
+        [self linkEntry:entry];
+        [self evictToCountLimit];
+    }
+}
+
+- (void)removeAllObjects
+{
+    @synchronized(self) {
+        [self.entries removeAllObjects];
+        
+        _generation ++;
+        
+        self.mostRecentlyUsed = nil;
+        self.leastRecentlyUsed = nil;
+    }
+}
+
+- (void)setCountLimit:(NSUInteger)countLimit
+{
+    @synchronized(self) {
+        _countLimit = countLimit;
+        
+        [self evictToCountLimit];
+    }
+}
+
+#pragma mark - Private Instance
+
+- (void)linkEntry:(ABFHeatMapTileCacheEntry *)entry
+{
+    entry.previous = nil;
+    entry.next = self.mostRecentlyUsed;
+    self.mostRecentlyUsed.previous = entry;
+    self.mostRecentlyUsed = entry;
+    
+    if (!self.leastRecentlyUsed) {
+        self.leastRecentlyUsed = entry;
+    }
+}
+
+- (void)unlinkEntry:(ABFHeatMapTileCacheEntry *)entry
+{
+    ABFHeatMapTileCacheEntry *previous = entry.previous;
+    ABFHeatMapTileCacheEntry *next = entry.next;
+    
+    if (previous) {
+        previous.next = next;
+    }
+    else {
+        self.mostRecentlyUsed = next;
+    }
+    
+    if (next) {
+        next.previous = previous;
+    }
+    else {
+        self.leastRecentlyUsed = previous;
+    }
+    
+    entry.previous = nil;
+    entry.next = nil;
+}
+
+- (void)evictToCountLimit
+{
+    while (self.countLimit > 0 &&
+           self.entries.count > self.countLimit) {
+        ABFHeatMapTileCacheEntry *entry = self.leastRecentlyUsed;
+        
+        [self unlinkEntry:entry];
+        [self.entries removeObjectForKey:entry.key];
+    }
+}
+
+@end
+
+#pragma mark - ABFHeatMapTileOverlay
+
+@interface ABFHeatMapTileOverlay ()
+
+@property (nonatomic, strong) ABFHeatMapTileCache *tileCache;
+
+@property (nonatomic, strong) NSOperationQueue *renderQueue;
+
+@property (atomic, strong) NSData *gradientTable;
+
+@end
+
+@implementation ABFHeatMapTileOverlay
+
+#pragma mark - Init
+
+- (instancetype)initWithEntityName:(NSString *)entityName
+                           inRealm:(RLMRealm *)realm
+                   latitudeKeyPath:(NSString *)latitudeKeyPath
+                  longitudeKeyPath:(NSString *)longitudeKeyPath
+{
+    self = [super initWithURLTemplate:nil];
+    
+    if (self) {
+        _entityName = entityName;
+        _realmConfiguration = realm.configuration;
+        _latitudeKeyPath = latitudeKeyPath;
+        _longitudeKeyPath = longitudeKeyPath;
+        
+        _radius = 12;
+        _saturationDensity = 8;
+        _tileCacheCountLimit = 256;
+        
+        _tileCache = [[ABFHeatMapTileCache alloc] init];
+        _tileCache.countLimit = _tileCacheCountLimit;
+        
+        _renderQueue = [[NSOperationQueue alloc] init];
+        _renderQueue.qualityOfService = NSQualityOfServiceUserInitiated;
+        
+        self.gradientColors = @[[UIColor blueColor],
+                                [UIColor cyanColor],
+                                [UIColor greenColor],
+                                [UIColor yellowColor],
+                                [UIColor redColor]];
+        
+        self.canReplaceMapContent = NO;
+    }
+    
+    return self;
+}
+
+#pragma mark - Public Instance
+
+- (void)reloadTiles
+{
+    [self.renderQueue cancelAllOperations];
+    [self.tileCache removeAllObjects];
+}
+
+#pragma mark - Setters
+
+- (void)setGradientColors:(NSArray<UIColor *> *)gradientColors
+{
+    _gradientColors = gradientColors;
+    
+    self.gradientTable = ABFGradientTableForColors(gradientColors);
+    
+    [self reloadTiles];
+}
+
+- (void)setRadius:(NSUInteger)radius
+{
+    _radius = radius;
+    
+    [self reloadTiles];
+}
+
+- (void)setSaturationDensity:(double)saturationDensity
+{
+    _saturationDensity = saturationDensity;
+    
+    [self reloadTiles];
+}
+
+- (void)setTileCacheCountLimit:(NSUInteger)tileCacheCountLimit
+{
+    _tileCacheCountLimit = tileCacheCountLimit;
+    
+    self.tileCache.countLimit = tileCacheCountLimit;
+}
+
+#pragma mark - MKTileOverlay
+
+- (void)loadTileAtPath:(MKTileOverlayPath)path
+                result:(void (^)(NSData *, NSError *))result
+{
+    NSString *cacheKey = [NSString stringWithFormat:@"%ld/%ld/%ld@%.0f",
+                          (long)path.z,(long)path.x,(long)path.y,path.contentScaleFactor];
+    
+    NSData *cachedTile = [self.tileCache objectForKey:cacheKey];
+    
+    if (cachedTile) {
+        result(cachedTile, nil);
+        
+        return;
+    }
+    
+    // Tiles rendered with the parameters from before a reload are not cached
+    NSUInteger generation = self.tileCache.generation;
+    
+    // Loads cancelled by reloadTiles finish with NSUserCancelledError, so MapKit never waits on a tile
+    __block NSData *tile = nil;
+    __block NSError *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil];
+    
+    NSBlockOperation *operation = [[NSBlockOperation alloc] init];
+    
+    typeof(self) __weak weakSelf = self;
+    typeof(operation) __weak weakOperation = operation;
+    
+    [operation addExecutionBlock:^{
+        @autoreleasepool {
+            if (weakOperation.isCancelled) {
+                return;
+            }
+            
+            NSData *renderedTile = nil;
+            
+            // Invalid key paths raise on the render queue, finish the load with the reason instead
+            @try {
+                renderedTile = [weakSelf renderTileAtPath:path];
+            }
+            @catch (NSException *exception) {
+                error = [NSError errorWithDomain:ABFHeatMapTileOverlayErrorDomain
+                                            code:1
+                                        userInfo:@{NSLocalizedDescriptionKey : exception.reason ?: exception.name}];
+                
+                return;
+            }
+            
+            // The data changed while rendering, don't cache a stale tile
+            if (weakOperation.isCancelled) {
+                return;
+            }
+            
+            if (renderedTile) {
+                [weakSelf.tileCache setObject:renderedTile forKey:cacheKey generation:generation];
+            }
+            
+            tile = renderedTile;
+            error = nil;
+        }
+    }];
+    
+    // Also runs for operations cancelled before they started
+    operation.completionBlock = ^{
+        result(tile, error);
+    };
+    
+    [self.renderQueue addOperation:operation];
+}
+
+#pragma mark - Private Instance
+
+- (NSData *)renderTileAtPath:(MKTileOverlayPath)path
+{
+    NSUInteger radius = self.radius;
+    NSUInteger tilePixels = (NSUInteger)(self.tileSize.width * MAX(path.contentScaleFactor, 1));
+    NSUInteger gridPixels = tilePixels + 2 * radius;
+    
+    // Map rect covered by the tile, padded so points just outside still blur into it
+    double tileMapSize = MKMapSizeWorld.width / pow(2, path.z);
+    double mapPointsPerPixel = tileMapSize / tilePixels;
+    double padding = radius * mapPointsPerPixel;
+    
+    MKMapPoint origin = MKMapPointMake(path.x * tileMapSize - padding,
+                                       path.y * tileMapSize - padding);
+    
+    double minY = MAX(origin.y, 0);
+    double maxY = MIN(origin.y + gridPixels * mapPointsPerPixel, MKMapSizeWorld.height);
+    
+    MKMapRect fetchRect = MKMapRectMake(origin.x, minY, gridPixels * mapPointsPerPixel, maxY - minY);
+    
+    NSMutableData *pixelData = [NSMutableData dataWithLength:tilePixels * tilePixels * sizeof(uint32_t)];
+    
+    NSData *mapPointData = [self mapPointsInMapRect:fetchRect];
+    const MKMapPoint *mapPoints = mapPointData.bytes;
+    NSUInteger pointCount = mapPointData.length / sizeof(MKMapPoint);
+    
+    if (pointCount > 0) {
+        ABFHeatMapTileParameters parameters = {
+            .tilePixels = (uint32_t)tilePixels,
+            .radius = (uint32_t)radius,
+            .saturationDensity = (float)self.saturationDensity,
+            .useSIMD = true
+        };
+        
+        // The rasterizer takes the x and y of the map points as separate arrays
+        NSMutableData *coordinateData = [NSMutableData dataWithLength:pointCount * 2 * sizeof(double)];
+        double *xs = coordinateData.mutableBytes;
+        double *ys = xs + pointCount;
+        
+        for (NSUInteger i = 0; i < pointCount; i++) {
+            xs[i] = mapPoints[i].x;
+            ys[i] = mapPoints[i].y;
+        }
+        
+        ABFHeatMapRenderTile(&parameters,
+                             xs,
+                             ys,
+                             pointCount,
+                             origin.x,
+                             origin.y,
+                             MKMapSizeWorld.width,
+                             mapPointsPerPixel,
+                             self.gradientTable.bytes,
+                             pixelData.mutableBytes);
+    }
+    
+    return [self PNGDataForPixels:pixelData tilePixels:tilePixels];
+}
+
+- (NSData *)mapPointsInMapRect:(MKMapRect)mapRect
+{
+    RLMRealm *realm = [RLMRealm realmWithConfiguration:self.realmConfiguration error:nil];
+    
+    if (!realm) {
+        return nil;
+    }
+    
+    MKCoordinateRegion region = MKCoordinateRegionForMapRect(mapRect);
+    
+    ABFLocationFetchRequest *fetchRequest =
+    [ABFLocationFetchRequest locationFetchRequestWithEntityName:self.entityName
+                                                        inRealm:realm
+                                                latitudeKeyPath:self.latitudeKeyPath
+                                               longitudeKeyPath:self.longitudeKeyPath
+                                                      forRegion:region];
+    
+    NSPredicate *basePredicate = self.basePredicate;
+    
+    if (basePredicate) {
+        fetchRequest.predicate = [NSCompoundPredicate andPredicateWithSubpredicates:@[fetchRequest.predicate,basePredicate]];
+    }
+    
+    RLMResults *fetchResults = fetchRequest.fetchObjects;
+    
+    NSMutableData *mapPointData = [NSMutableData dataWithLength:fetchResults.count * sizeof(MKMapPoint)];
+    MKMapPoint *mapPoints = mapPointData.mutableBytes;
+    
+    NSUInteger index = 0;
+    
+    for (RLMObject *object in fetchResults) {
+        CLLocationDegrees latitude = 0;
+        CLLocationDegrees longitude = 0;
+        
+        @try {
+            latitude = ((NSNumber *)[object valueForKeyPath:self.latitudeKeyPath]).doubleValue;
+        }
+        @catch (NSException *exception) {
+            @throw [NSException exceptionWithName:@"ABFException"
+                                           reason:@"Latitude key path for heat map entity name not valid"
+                                         userInfo:nil];
+        }
+        
+        @try {
+            longitude = ((NSNumber *)[object valueForKeyPath:self.longitudeKeyPath]).doubleValue;
+        }
+        @catch (NSException *exception) {
+            @throw [NSException exceptionWithName:@"ABFException"
+                                           reason:@"Longitude key path for heat map entity name not valid"
+                                         userInfo:nil];
+        }
+        
+        mapPoints[index++] = MKMapPointForCoordinate(CLLocationCoordinate2DMake(latitude, longitude));
+    }
+    
+    return mapPointData;
+}
+
+- (NSData *)PNGDataForPixels:(NSData *)pixelData
+                  tilePixels:(NSUInteger)tilePixels
+{
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    
+    CGContextRef context = CGBitmapContextCreate((void *)pixelData.bytes,
+                                                 tilePixels,
+                                                 tilePixels,
+                                                 8,
+                                                 tilePixels * sizeof(uint32_t),
+                                                 colorSpace,
+                                                 kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+    
+    CGImageRef imageRef = CGBitmapContextCreateImage(context);
+    
+    NSData *data = UIImagePNGRepresentation([UIImage imageWithCGImage:imageRef]);
+    
+    CGImageRelease(imageRef);
+    CGContextRelease(context);
+    CGColorSpaceRelease(colorSpace);
+    
+    return data;
+}
+
+@end
@@ -31,6 +31,25 @@ extern NSPredicate * NSPredicateForCoordinateRegion(MKCoordinateRegion region,
                                                     NSString *longitudeKeyPath);
 NS_ASSUME_NONNULL_END
 
+/**
+ *  Converts several MKCoordinate regions to an NSPredicate that matches a location in any of them
+ *
+ *  Regions that span 360 degrees of longitude only limit the latitude. Used for the coverings of circle and polygon fetch requests.
+ *
+ *  @param regions          array of MKCoordinate regions
+ *  @param count            number of regions
+ *  @param latitudeKeyPath  the latitude key path for the value to test the latitude limits against
+ *  @param longitudeKeyPath the longitude key path for the value to test the longitude limits against
+ *
+ *  @return instance of NSPredicate (an NSCompoundPredicate for more than one region, FALSEPREDICATE for none)
+ */
+NS_ASSUME_NONNULL_BEGIN
+extern NSPredicate * NSPredicateForCoordinateRegions(const MKCoordinateRegion *regions,
+                                                     NSUInteger count,
+                                                     NSString *latitudeKeyPath,
+                                                     NSString *longitudeKeyPath);
+NS_ASSUME_NONNULL_END
+
 /**
  *  Location specific subclass of RBQFetchRequest that allows for location fetching on Realm objects that contain latitude and longitude values.
  *
@@ -119,6 +138,19 @@ NS_ASSUME_NONNULL_END
  */
 - (BOOL)evaluateObject:(nonnull RLMObject *)object;
 
+/**
+ *  Tests which coordinates of fetched objects are part of the fetch.
+ *
+ *  The predicate of a fetch request can be a coarse filter: circle and polygon fetch requests query Realm for a covering of coordinate regions and test the exact shape here, over batches of coordinates. The coordinate region predicate is exact, so the default implementation includes every coordinate.
+ *
+ *  @param coordinates coordinates of objects returned by fetchObjects
+ *  @param count       number of coordinates
+ *  @param results     array with room for count values that receives YES for the coordinates in the fetch
+ */
+- (void)evaluateCoordinates:(nonnull const CLLocationCoordinate2D *)coordinates
+                      count:(NSUInteger)count
+                    results:(nonnull BOOL *)results;
+
 /**
  *  Create RBQFetchRequest in RLMRealm instance with an entity name
  *
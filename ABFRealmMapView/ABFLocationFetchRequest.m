@@ -9,6 +9,19 @@
 #import "ABFLocationFetchRequest.h"
 #import <Realm/RLMRealm_Dynamic.h>
 
+#pragma mark - Private Functions
+
+/**
+ *  The halves of a region split at the -180/180 meridian have strict bounds on both sides of it, so locations on the meridian match neither
+ */
+static NSPredicate * NSPredicateForMeridian(CLLocationDegrees minLat,
+                                            CLLocationDegrees maxLat,
+                                            NSString *latitudeKeyPath,
+                                            NSString *longitudeKeyPath)
+{
+    return [NSPredicate predicateWithFormat:@"%K < %f AND %K > %f AND (%K == 180 OR %K == -180)",latitudeKeyPath,maxLat,latitudeKeyPath,minLat,longitudeKeyPath,longitudeKeyPath];
+}
+
 #pragma mark - Public Functions
 
 NSPredicate * NSPredicateForCoordinateRegion(MKCoordinateRegion region,
@@ -48,8 +61,9 @@ NSPredicate * NSPredicateForCoordinateRegion(MKCoordinateRegion region,
         
         NSPredicate *overflowPredicate = NSPredicateForCoordinateRegion(overflowRegion, latitudeKeyPath, longitudeKeyPath);
         NSPredicate *boundedPredicate = NSPredicateForCoordinateRegion(boundedRegion, latitudeKeyPath, longitudeKeyPath);
+        NSPredicate *meridianPredicate = NSPredicateForMeridian(minLat, maxLat, latitudeKeyPath, longitudeKeyPath);
         
-        NSCompoundPredicate *compoundPredicate = [NSCompoundPredicate orPredicateWithSubpredicates:@[overflowPredicate,boundedPredicate]];
+        NSCompoundPredicate *compoundPredicate = [NSCompoundPredicate orPredicateWithSubpredicates:@[overflowPredicate,boundedPredicate,meridianPredicate]];
         
         return compoundPredicate;
     }
@@ -72,8 +86,9 @@ NSPredicate * NSPredicateForCoordinateRegion(MKCoordinateRegion region,
         
         NSPredicate *overflowPredicate = NSPredicateForCoordinateRegion(overflowRegion, latitudeKeyPath, longitudeKeyPath);
         NSPredicate *boundedPredicate = NSPredicateForCoordinateRegion(boundedRegion, latitudeKeyPath, longitudeKeyPath);
+        NSPredicate *meridianPredicate = NSPredicateForMeridian(minLat, maxLat, latitudeKeyPath, longitudeKeyPath);
         
-        NSCompoundPredicate *compoundPredicate = [NSCompoundPredicate orPredicateWithSubpredicates:@[overflowPredicate,boundedPredicate]];
+        NSCompoundPredicate *compoundPredicate = [NSCompoundPredicate orPredicateWithSubpredicates:@[overflowPredicate,boundedPredicate,meridianPredicate]];
         
         return compoundPredicate;
     }
@@ -83,6 +98,39 @@ NSPredicate * NSPredicateForCoordinateRegion(MKCoordinateRegion region,
     return predicate;
 }
 
+NSPredicate * NSPredicateForCoordinateRegions(const MKCoordinateRegion *regions,
+                                              NSUInteger count,
+                                              NSString *latitudeKeyPath,
+                                              NSString *longitudeKeyPath)
+{
+    NSMutableArray *subpredicates = [NSMutableArray arrayWithCapacity:count];
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        MKCoordinateRegion region = regions[i];
+        
+        if (region.span.longitudeDelta >= 360) {
+            // Bands around a pole cover every longitude
+            CLLocationDegrees halfLatDelta = region.span.latitudeDelta/2;
+            
+            [subpredicates addObject:[NSPredicate predicateWithFormat:@"%K < %f AND %K > %f",
+                                      latitudeKeyPath,region.center.latitude + halfLatDelta,
+                                      latitudeKeyPath,region.center.latitude - halfLatDelta]];
+        }
+        else {
+            [subpredicates addObject:NSPredicateForCoordinateRegion(region, latitudeKeyPath, longitudeKeyPath)];
+        }
+    }
+    
+    if (subpredicates.count == 0) {
+        return [NSPredicate predicateWithValue:NO];
+    }
+    else if (subpredicates.count == 1) {
+        return subpredicates.firstObject;
+    }
+    
+    return [NSCompoundPredicate orPredicateWithSubpredicates:subpredicates];
+}
+
 @interface ABFLocationFetchRequest ()
 
 @property (strong, nonatomic) RLMRealm *realmForMainThread; // Improves scroll performance
@@ -169,6 +217,13 @@ realmConfiguration = _realmConfiguration;
     return sameEntity;
 }
 
+- (void)evaluateCoordinates:(const CLLocationCoordinate2D *)coordinates
+                      count:(NSUInteger)count
+                    results:(BOOL *)results
+{
+    memset(results, YES, count * sizeof(BOOL));
+}
+
 #pragma mark - Getter
 
 - (RLMRealm *)realm
@@ -7,6 +7,7 @@
 //
 
 #import "ABFLocationFetchRequest.h"
+#import "ABFMapLayer.h"
 
 @import Foundation;
 @import MapKit;
@@ -53,6 +54,11 @@ extern const double ABFNoDistance;
  */
 @property (nonatomic, readonly, nonnull) RLMThreadSafeReference *threadSafeReference;
 
+/**
+ *  The identifier of the ABFMapLayer the object was fetched for, nil if the fetch was not layered.
+ */
+@property (nonatomic, readonly, nullable) NSString *layerIdentifier;
+
 /**
  *  Creates an instance of ABFLocationSafeRealmObject.
  *
@@ -107,8 +113,8 @@ typedef NS_ENUM(NSUInteger, ABFAnnotationType){
 @property (nonatomic, readonly) CLLocationCoordinate2D coordinate;
 
 /**
- *  The title of the annotation. If the annotation is a cluster then this title is computed,
- *  for example '6 objects in this area'.
+ *  The title of the annotation. If the annotation is a cluster then this title is computed
+ *  the first time it is requested, for example '6 objects in this area'.
  *
  *  @see ABFLocationFetchedResultsController clusterTitleFormatString
  */
@@ -133,6 +139,27 @@ typedef NS_ENUM(NSUInteger, ABFAnnotationType){
  */
 @property (nonatomic, readonly, nonnull) NSArray<ABFLocationSafeRealmObject *> *safeObjects;
 
+/**
+ *  The number of objects the annotation represents.
+ *
+ *  Equal to the number of safe objects, except for clusters from an aggregate-only fetch, which have no safe objects.
+ *
+ *  @see ABFLocationFetchedResultsController aggregateOnly
+ */
+@property (nonatomic, readonly) NSUInteger objectCount;
+
+/**
+ *  The identifier of the ABFMapLayer of the object if the annotation is unique and the fetch was layered, otherwise nil.
+ */
+@property (nonatomic, readonly, nullable) NSString *layerIdentifier;
+
+/**
+ *  The number of objects of each layer in the annotation, keyed by ABFMapLayer identifier.
+ *
+ *  Layers without objects in the annotation are not included; nil if the fetch was not layered.
+ */
+@property (nonatomic, readonly, nullable) NSDictionary<NSString *, NSNumber *> *objectCountsByLayer;
+
 /**
  *  Creates an instance of ABFAnnotation for a given type
  *
@@ -285,6 +312,16 @@ typedef NSInteger ABFResultsLimit;
  */
 @property (nonatomic, readonly, nonnull) ABFLocationFetchRequest *fetchRequest;
 
+/**
+ *  The layers fetched by the controller, nil unless set with updateLayers:fetchRequests:
+ */
+@property (nonatomic, readonly, nullable) NSArray<ABFMapLayer *> *layers;
+
+/**
+ *  The fetch request of each layer, in the same order as layers
+ */
+@property (nonatomic, readonly, nullable) NSArray<ABFLocationFetchRequest *> *layerFetchRequests;
+
 /**
  *  Specify a sort descriptor to sort the objects by distance.
  *
@@ -344,12 +381,69 @@ typedef NSInteger ABFResultsLimit;
 /**
  *  The limit on how many results from Realm will be added to the map.
  *
- *  This applies whether or not clustering is enabled.
+ *  This applies whether or not clustering is enabled, and to each layer of a layered fetch.
  *
  *  Default is -1, or unlimited results.
  */
 @property (nonatomic, assign) ABFResultsLimit resultsLimit;
 
+/**
+ *  The maximum number of recycled annotations kept for reuse by the next fetch.
+ *
+ *  Default is 2048
+ *
+ *  @see replaceAnnotations:withDisplayedAnnotations:
+ */
+@property (nonatomic, assign) NSUInteger annotationPoolLimit;
+
+/**
+ *  The number of ABFAnnotation instances allocated by the last fetch.
+ */
+@property (nonatomic, readonly) NSUInteger allocatedAnnotationCount;
+
+/**
+ *  The number of recycled ABFAnnotation instances reused by the last fetch.
+ */
+@property (nonatomic, readonly) NSUInteger reusedAnnotationCount;
+
+/**
+ *  The number of containers allocated by the last fetch for the annotations' objects: the safeObjects array of each annotation and, for layered clusters, the objectCountsByLayer dictionary.
+ *
+ *  Together with allocatedAnnotationCount, this is the number of allocations per annotation a fetch makes. The safe objects themselves are allocated by the Realm enumeration and counted in objectCount.
+ */
+@property (nonatomic, readonly) NSUInteger allocatedContainerCount;
+
+/**
+ *  Approximate number of bytes the controller may hold for its safe objects, annotations, annotation pool and clustering buffers.
+ *
+ *  A clustering fetch estimated to exceed the budget is performed aggregate-only. Once the budget is exceeded, the annotation pool and clustering buffers are released first.
+ *
+ *  Default is 0, or no budget.
+ *
+ *  @see aggregateOnly
+ */
+@property (nonatomic, assign) NSUInteger memoryBudget;
+
+/**
+ *  Set while the system reports memory pressure. Clustering fetches are aggregate-only, and the caches are released before each fetch.
+ *
+ *  Default is NO
+ */
+@property (atomic, assign) BOOL underMemoryPressure;
+
+/**
+ *  Estimate of the bytes currently held by the controller, updated after each fetch.
+ */
+@property (atomic, readonly) NSUInteger memoryUsage;
+
+/**
+ *  YES if the last fetch was aggregate-only.
+ *
+ *  Aggregate-only clusters only have an objectCount, so no safe objects are created for their members;
+ *  safeObjects then contains the objects of the single object annotations only (not sorted).
+ */
+@property (nonatomic, readonly) BOOL aggregateOnly;
+
 /**
  *  Creates an instance of ABFLocationFetchedResultsController. 
  *
@@ -390,6 +484,33 @@ typedef NSInteger ABFResultsLimit;
 - (BOOL)performClusteringFetchForVisibleMapRect:(MKMapRect)visibleMapRect
                                       zoomScale:(MKZoomScale)zoomScale;
 
+/**
+ *  Checks the current fetch request against the memory budget, without creating safe objects.
+ *
+ *  @return YES if under memory pressure or the fetch is estimated to exceed memoryBudget
+ */
+- (BOOL)fetchRequestExceedsMemoryBudget;
+
+/**
+ *  Releases the annotation pool and clustering buffers.
+ *
+ *  @warning Must not be called while a fetch is performed on another thread.
+ */
+- (void)reduceMemoryUsage;
+
+/**
+ *  Splits the annotations of the previous fetch into unique annotations for the objects within a region, without fetching from Realm.
+ *
+ *  The members of each cluster become unique annotations, so annotations for single objects compare equal to the previous ones. Use when zooming into a region that is contained by the region of the previous fetch, and the Realm has not changed since.
+ *
+ *  @warning Objects outside the previous fetch are not found; a results limit that truncated the previous fetch is not accounted for.
+ *
+ *  @param region the region to keep objects within
+ *
+ *  @return BOOL value indicating if the split was successful, NO if the previous fetch was aggregate-only
+ */
+- (BOOL)performSplitFetchForRegion:(MKCoordinateRegion)region;
+
 /**
  *  Updates the current fetch request to a new instance.
  *
@@ -403,4 +524,30 @@ typedef NSInteger ABFResultsLimit;
                       titleKeyPath:(nullable NSString *)titleKeyPath
                    subtitleKeyPath:(nullable NSString *)subtitleKeyPath;
 
+/**
+ *  Updates the controller to fetch several layers.
+ *
+ *  Fetches then run the fetch request of each layer concurrently (each on its own thread) and combine the objects, so clusters can contain objects of several layers. The title and subtitle key paths are read from each layer. Calling updateLocationFetchRequest:titleKeyPath:subtitleKeyPath: ends the layered fetch.
+ *
+ *  @warning Must call performFetch or performClusteringFetchForVisibleMapRect:atZoomScale: after to trigger the fetch.
+ *
+ *  @param layers        the layers to fetch, with unique identifiers
+ *  @param fetchRequests one fetch request for each layer, in the same order
+ */
+- (void)updateLayers:(nonnull NSArray<ABFMapLayer *> *)layers
+       fetchRequests:(nonnull NSArray<ABFLocationFetchRequest *> *)fetchRequests;
+
+/**
+ *  Replaces the annotations of the last fetch with the equal instances that are displayed on the map, so the next fetch can reuse the fetched instances that are never shown.
+ *
+ *  A map diff keeps the annotations already on the map when the fetch returns equal ones. The fetched duplicates leave annotations before they are pooled and reconfigured, so annotations never contains an instance that is being reused.
+ *
+ *  Nothing happens if annotations is no longer the controller's annotations (a newer fetch replaced them).
+ *
+ *  @param annotations          the annotations of the fetch that was diffed
+ *  @param displayedAnnotations the annotations displayed for the fetch, equal to annotations, preferring instances that were already on the map
+ */
+- (void)replaceAnnotations:(nonnull NSSet<ABFAnnotation *> *)annotations
+  withDisplayedAnnotations:(nonnull NSSet<ABFAnnotation *> *)displayedAnnotations;
+
 @end
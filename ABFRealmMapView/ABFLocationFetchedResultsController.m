@@ -7,17 +7,26 @@
 //
 
 #import "ABFLocationFetchedResultsController.h"
+#import "ABFClusterAggregate.h"
+
+#import <objc/runtime.h>
 
 #pragma mark - Constants
 
 const double ABFNoDistance = DBL_MAX;
 
+/**
+ *  Number of fetched objects whose coordinates the fetch request evaluates at a time
+ */
+static const NSUInteger ABFCoordinateBatchSize = 256;
+
 #pragma mark - ABFLocationSafeRealmObject
 
 @interface ABFLocationSafeRealmObject()
 
 @property (nonatomic, strong) id internalObject;
 @property (nonatomic, strong) RLMRealmConfiguration *realmConfiguration;
+@property (nonatomic, strong, readwrite) NSString *layerIdentifier;
 
 @end
 
@@ -89,6 +98,7 @@ const double ABFNoDistance = DBL_MAX;
     safeObject->_coordinate = _coordinate;
     safeObject->_title = _title;
     safeObject->_subtitle = _subtitle;
+    safeObject->_layerIdentifier = _layerIdentifier;
     
     return safeObject;
 }
@@ -99,71 +109,190 @@ const double ABFNoDistance = DBL_MAX;
 
 static const NSUInteger ABFMaxPrecision = 22;
 static const NSUInteger ABFBitsPerBase32Char = 5;
-static const char ABFBase32Chars[] = "0123456789bcdefghjkmnpqrstuvwxyz";
 
-static char ABFValueToBase32Character(NSUInteger value)
+/**
+ *  Bisects the range the same way a geohash does for one axis, returning the bits for that axis.
+ *
+ *  A geohash of ABFMaxPrecision characters interleaves 55 bits of longitude and 55 bits of latitude,
+ *  so two coordinates have equal geohashes exactly when both of their axis bits are equal. Comparing
+ *  the bits avoids creating the geohash string.
+ */
+static uint64_t ABFGeoHashBitsForValue(double value,
+                                       double minValue,
+                                       double maxValue,
+                                       NSUInteger bitCount)
 {
-    if (value > 31) {
-        @throw [NSException exceptionWithName:@"ABFException" reason:@"Not a valid base32 value" userInfo:nil];
+    uint64_t bits = 0;
+    
+    for (NSUInteger i = 0; i < bitCount; i++) {
+        double mid = (minValue + maxValue)/2;
+        if (value > mid) {
+            bits = (bits << 1) + 1;
+            minValue = mid;
+        } else {
+            bits = (bits << 1) + 0;
+            maxValue = mid;
+        }
     }
     
-    return ABFBase32Chars[value];
+    return bits;
 }
 
-static NSString *ABFGeoHashWithCoordinate(CLLocationCoordinate2D coordinate,
-                                          NSUInteger precision)
+/**
+ *  Matches the bounding box of NSPredicateForCoordinateRegion, including regions that cross the antimeridian
+ */
+static BOOL ABFCoordinateRegionContainsCoordinate(MKCoordinateRegion region,
+                                                  CLLocationCoordinate2D coordinate)
 {
-    if (precision > ABFMaxPrecision) {
-        
-        NSInteger precisionLimit = ABFMaxPrecision + 1;
-        
-        NSString *exceptionString = [NSString stringWithFormat:@"Precision must be less than %td",precisionLimit];
+    if (fabs(coordinate.latitude - region.center.latitude) >= region.span.latitudeDelta/2) {
+        return NO;
+    }
+    
+    // Longitude difference wrapped to [-180, 180)
+    double longitudeDelta = fmod(coordinate.longitude - region.center.longitude + 540.0, 360.0) - 180.0;
+    
+    return fabs(longitudeDelta) < region.span.longitudeDelta/2;
+}
+
+#pragma mark - Arena
+
+/**
+ *  Bump allocator for the intermediate clustering structures.
+ *
+ *  The buffer is kept between refreshes and only grows, so a steady stream of refreshes
+ *  does not allocate once the largest fetch has been seen.
+ */
+typedef struct {
+    void *buffer;
+    size_t capacity;
+    size_t offset;
+} ABFArena;
+
+static void ABFArenaReset(ABFArena *arena, size_t requiredCapacity)
+{
+    arena->offset = 0;
+    
+    if (arena->capacity < requiredCapacity) {
+        size_t capacity = MAX(requiredCapacity, arena->capacity * 2);
         
-        @throw [NSException exceptionWithName:@"ABFException" reason:exceptionString userInfo:nil];
+        free(arena->buffer);
+        arena->buffer = malloc(capacity);
+        arena->capacity = arena->buffer ? capacity : 0;
     }
+}
+
+static void *ABFArenaAlloc(ABFArena *arena, size_t size)
+{
+    size_t alignedOffset = (arena->offset + 15) & ~(size_t)15;
     
-    double longitudeRange[] = {-180, 180};
-    double latitudeRange[] = {-90, 90};
+    if (alignedOffset + size > arena->capacity) {
+        return NULL;
+    }
     
-    char buffer[precision+1];
-    buffer[precision] = 0;
+    arena->offset = alignedOffset + size;
     
-    for (NSUInteger i = 0; i < precision; i++) {
-        NSUInteger hashVal = 0;
-        for (NSUInteger j = 0; j < ABFBitsPerBase32Char; j++) {
-            BOOL even = ((i*ABFBitsPerBase32Char)+j) % 2 == 0;
-            double val = even ? coordinate.longitude : coordinate.latitude;
-            double* range = even ? longitudeRange : latitudeRange;
-            double mid = (range[0] + range[1])/2;
-            if (val > mid) {
-                hashVal = (hashVal << 1) + 1;
-                range[0] = mid;
-            } else {
-                hashVal = (hashVal << 1) + 0;
-                range[1] = mid;
-            }
-        }
-        buffer[i] = ABFValueToBase32Character(hashVal);
+    return (char *)arena->buffer + alignedOffset;
+}
+
+static void ABFArenaFree(ABFArena *arena)
+{
+    free(arena->buffer);
+    arena->buffer = NULL;
+    arena->capacity = 0;
+    arena->offset = 0;
+}
+
+/**
+ *  A safe object's position in the cluster grid
+ */
+typedef struct {
+    uint64_t key;
+    NSUInteger index;
+    CLLocationCoordinate2D coordinate;
+} ABFClusterCell;
+
+static int ABFClusterCellCompare(const void *a, const void *b)
+{
+    const ABFClusterCell *cellA = a;
+    const ABFClusterCell *cellB = b;
+    
+    if (cellA->key != cellB->key) {
+        return cellA->key < cellB->key ? -1 : 1;
+    }
+    
+    // Keep the fetch (and distance sort) order within a cluster
+    if (cellA->index != cellB->index) {
+        return cellA->index < cellB->index ? -1 : 1;
     }
-    NSString *geoHashValue = [NSString stringWithUTF8String:buffer];
     
-    return geoHashValue;
+    return 0;
 }
 
+#pragma mark - Memory Estimates
+
+/**
+ *  Estimated bytes of a RLMThreadSafeReference (and the handover data it retains)
+ */
+static const NSUInteger ABFEstimatedThreadSafeReferenceSize = 96;
+
+/**
+ *  Estimated bytes of the title and subtitle of an object, used before the objects are read
+ */
+static const NSUInteger ABFEstimatedStringsSize = 64;
+
+static NSUInteger ABFEstimatedSizeOfSafeObject(ABFLocationSafeRealmObject *safeObject)
+{
+    return (class_getInstanceSize([ABFLocationSafeRealmObject class]) +
+            ABFEstimatedThreadSafeReferenceSize +
+            (safeObject.title.length + safeObject.subtitle.length) * sizeof(unichar));
+}
+
+/**
+ *  Estimate for a full (not aggregate-only) fetch: a safe object, its cluster cell and the references to it
+ */
+static NSUInteger ABFEstimatedFetchSizeForObjectCount(NSUInteger count)
+{
+    NSUInteger objectSize = (class_getInstanceSize([ABFLocationSafeRealmObject class]) +
+                             ABFEstimatedThreadSafeReferenceSize +
+                             ABFEstimatedStringsSize +
+                             sizeof(ABFClusterCell) +
+                             2 * sizeof(id));
+    
+    return count * objectSize;
+}
 
 #pragma mark - ABFAnnotation
 
-@interface ABFAnnotation ()
+@interface ABFAnnotation () {
+    uint64_t _geoHashLongitudeBits;
+    uint64_t _geoHashLatitudeBits;
+    BOOL _hasGeoHash;
+}
+
+@property (nonatomic, strong) NSArray *internalSafeObjects;
 
-@property (nonatomic, strong) NSMutableArray *internalSafeObjects;
+/**
+ *  Format for the lazily computed title of a cluster
+ */
+@property (nonatomic, strong) NSString *clusterTitleFormatString;
 
-@property (nonatomic, strong) NSString *geoHash;
+@property (nonatomic, strong, readwrite) NSDictionary *objectCountsByLayer;
 
-- (void)addSafeObject:(ABFLocationSafeRealmObject *)safeObject;
+- (void)prepareWithType:(ABFAnnotationType)type
+             coordinate:(CLLocationCoordinate2D)coordinate
+            safeObjects:(NSArray *)safeObjects
+                  title:(NSString *)title
+               subtitle:(NSString *)subtitle
+clusterTitleFormatString:(NSString *)clusterTitleFormatString;
+
+- (void)prepareAggregateClusterWithCoordinate:(CLLocationCoordinate2D)coordinate
+                                  objectCount:(NSUInteger)objectCount
+                     clusterTitleFormatString:(NSString *)clusterTitleFormatString;
 
 @end
 
 @implementation ABFAnnotation
+@synthesize title = _title;
 
 #pragma mark - Public Class
 
@@ -181,6 +310,7 @@ static NSString *ABFGeoHashWithCoordinate(CLLocationCoordinate2D coordinate,
 {
     [self willChangeValueForKey:@"coordinate"];
     _coordinate = newCoordinate;
+    _hasGeoHash = NO;
     [self didChangeValueForKey:@"coordinate"];
 }
 
@@ -205,16 +335,60 @@ static NSString *ABFGeoHashWithCoordinate(CLLocationCoordinate2D coordinate,
     self = [super init];
     
     if (self) {
-        _internalSafeObjects = [NSMutableArray array];
+        _internalSafeObjects = @[];
     }
     
     return self;
 }
 
-- (void)addSafeObject:(ABFLocationSafeRealmObject *)safeObject
+/**
+ *  Configures a new or recycled annotation before it is returned from a fetch (no KVO, it is not on a map)
+ */
+- (void)prepareWithType:(ABFAnnotationType)type
+             coordinate:(CLLocationCoordinate2D)coordinate
+            safeObjects:(NSArray *)safeObjects
+                  title:(NSString *)title
+               subtitle:(NSString *)subtitle
+clusterTitleFormatString:(NSString *)clusterTitleFormatString
+{
+    _type = type;
+    _coordinate = coordinate;
+    _hasGeoHash = NO;
+    _internalSafeObjects = safeObjects;
+    _objectCount = safeObjects.count;
+    _layerIdentifier = (type == ABFAnnotationTypeUnique) ? [safeObjects.firstObject layerIdentifier] : nil;
+    _objectCountsByLayer = nil;
+    _title = title;
+    _subtitle = subtitle;
+    _clusterTitleFormatString = clusterTitleFormatString;
+}
+
+/**
+ *  Configures a cluster that only knows how many objects it contains
+ */
+- (void)prepareAggregateClusterWithCoordinate:(CLLocationCoordinate2D)coordinate
+                                  objectCount:(NSUInteger)objectCount
+                     clusterTitleFormatString:(NSString *)clusterTitleFormatString
+{
+    [self prepareWithType:ABFAnnotationTypeCluster
+               coordinate:coordinate
+              safeObjects:@[]
+                    title:nil
+                 subtitle:nil
+ clusterTitleFormatString:clusterTitleFormatString];
+    
+    _objectCount = objectCount;
+}
+
+- (void)computeGeoHashIfNeeded
 {
-    @synchronized(self) {
-        [self.internalSafeObjects addObject:safeObject];
+    if (!_hasGeoHash) {
+        NSUInteger totalBits = ABFMaxPrecision * ABFBitsPerBase32Char;
+        
+        // Geohash bits alternate starting with longitude, so longitude gets the extra bit
+        _geoHashLongitudeBits = ABFGeoHashBitsForValue(_coordinate.longitude, -180, 180, (totalBits + 1)/2);
+        _geoHashLatitudeBits = ABFGeoHashBitsForValue(_coordinate.latitude, -90, 90, totalBits/2);
+        _hasGeoHash = YES;
     }
 }
 
@@ -222,23 +396,40 @@ static NSString *ABFGeoHashWithCoordinate(CLLocationCoordinate2D coordinate,
 
 - (NSArray *)safeObjects
 {
-    return self.internalSafeObjects.copy;
+    return self.internalSafeObjects;
 }
 
-- (NSString *)geoHash
+- (NSDictionary *)objectCountsByLayer
 {
-    if (!_geoHash) {
-        _geoHash = ABFGeoHashWithCoordinate(self.coordinate, ABFMaxPrecision);
+    if (!_objectCountsByLayer &&
+        _layerIdentifier) {
+        return @{_layerIdentifier : @1};
     }
     
-    return _geoHash;
+    return _objectCountsByLayer;
+}
+
+- (NSString *)title
+{
+    // Cluster titles are only built when something asks for them (e.g. the callout)
+    if (!_title &&
+        _clusterTitleFormatString) {
+        
+        NSString *countString = [NSString stringWithFormat:@"%lu",(unsigned long)_objectCount];
+        
+        _title = [_clusterTitleFormatString stringByReplacingOccurrencesOfString:@"$OBJECTSCOUNT" withString:countString];
+    }
+    
+    return _title;
 }
 
 #pragma mark - Equality
 
 - (NSUInteger)hash
 {
-    return [self.geoHash hash];
+    [self computeGeoHashIfNeeded];
+    
+    return (NSUInteger)(_geoHashLongitudeBits ^ (_geoHashLatitudeBits * 31));
 }
 
 - (BOOL)isEqual:(id)object
@@ -254,11 +445,16 @@ static NSString *ABFGeoHashWithCoordinate(CLLocationCoordinate2D coordinate,
 
     ABFAnnotation *annotation = (ABFAnnotation *)object;
     
-    NSString *objectGeoHash = ABFGeoHashWithCoordinate(annotation.coordinate, ABFMaxPrecision);
+    [self computeGeoHashIfNeeded];
+    [annotation computeGeoHashIfNeeded];
     
-    if ([self.geoHash isEqualToString:objectGeoHash]) {
+    if (_geoHashLongitudeBits == annotation->_geoHashLongitudeBits &&
+        _geoHashLatitudeBits == annotation->_geoHashLatitudeBits &&
+        self.type == annotation.type) {
         
-        return self.type == annotation.type;
+        // Objects of different layers at the same location are separate annotations
+        return (_layerIdentifier == annotation->_layerIdentifier ||
+                [_layerIdentifier isEqualToString:annotation->_layerIdentifier]);
     }
     
     return NO;
@@ -363,7 +559,22 @@ ABFClusterSizeForZoomLevel ABFDefaultClusterSizeForZoomLevel()
 
 #pragma mark - ABFLocationFetchedResultsController
 
-@interface ABFLocationFetchedResultsController ()
+@interface ABFLocationFetchedResultsController () {
+    ABFArena _clusterArena;
+    NSUInteger _fetchMemoryUsage;
+}
+
+@property (atomic, readwrite) NSUInteger memoryUsage;
+
+/**
+ *  Annotations discarded by the map's diff, reused by the next fetch
+ */
+@property (nonatomic, strong) NSMutableArray<ABFAnnotation *> *annotationPool;
+
+/**
+ *  One controller per layer, configured with the layer's fetch request and key paths
+ */
+@property (nonatomic, strong) NSArray<ABFLocationFetchedResultsController *> *layerControllers;
 
 @end
 
@@ -396,18 +607,33 @@ ABFClusterSizeForZoomLevel ABFDefaultClusterSizeForZoomLevel()
         _annotations = [[NSSet alloc] init];
         _clusterSizeBlock = ABFDefaultClusterSizeForZoomLevel();
         _resultsLimit = -1;
+        _annotationPool = [NSMutableArray array];
+        _annotationPoolLimit = 2048;
     }
     
     return self;
 }
 
+- (void)dealloc
+{
+    ABFArenaFree(&_clusterArena);
+}
+
 - (BOOL)performFetch
 {
+    if (self.underMemoryPressure) {
+        [self releaseCaches];
+    }
+    
     // Get the safe objects
-    _safeObjects = [self safeObjectsFromFetchResults:self.fetchRequest.fetchObjects];
+    _safeObjects = [self fetchSafeObjects];
     
     _annotations = [self uniqueAnnotationsFromSafeObjects:_safeObjects];
     
+    _aggregateOnly = NO;
+    
+    [self updateFetchMemoryUsage];
+    
     return YES;
 }
 
@@ -422,46 +648,84 @@ ABFClusterSizeForZoomLevel ABFDefaultClusterSizeForZoomLevel()
     // Create scale factor based on zoom scale and cluster size
     double scaleFactor = zoomScale/(double)clusterSize;
     
-    NSMutableDictionary *clusterGrid = [NSMutableDictionary dictionary];
+    if (self.underMemoryPressure) {
+        [self releaseCaches];
+    }
     
-    // Get the safe objects
-    _safeObjects = [self safeObjectsFromFetchResults:self.fetchRequest.fetchObjects];
+    _aggregateOnly = [self fetchRequestExceedsMemoryBudget];
     
-    // Insert safe objects into cluster array
-    for (ABFLocationSafeRealmObject *safeObject in _safeObjects) {
-        
-        MKMapPoint safeObjectPoint = MKMapPointForCoordinate(safeObject.coordinate);
-        
-        // Get x/y values adjusted for scale factor
-        NSUInteger x = floor(safeObjectPoint.x * scaleFactor);
-        NSUInteger y = floor(safeObjectPoint.y * scaleFactor);
+    if (_aggregateOnly) {
+        // Only keep running totals per cell, safe objects are created for single object cells
+        _annotations = [self aggregateClusterAnnotationsWithScaleFactor:scaleFactor];
+    }
+    else {
+        // Get the safe objects
+        _safeObjects = [self fetchSafeObjects];
         
-        NSMutableDictionary *yDict = [clusterGrid objectForKey:@(x)];
+        // Create annotations from cluster grid
+        _annotations = [self clusterAnnotationsFromSafeObjects:_safeObjects scaleFactor:scaleFactor];
+    }
+    
+    [self updateFetchMemoryUsage];
+    
+    return YES;
+}
+
+- (BOOL)fetchRequestExceedsMemoryBudget
+{
+    if (self.underMemoryPressure) {
+        return YES;
+    }
+    
+    if (self.memoryBudget == 0) {
+        return NO;
+    }
+    
+    NSArray *fetchRequests = self.layerFetchRequests ? self.layerFetchRequests : @[self.fetchRequest];
+    
+    NSUInteger count = 0;
+    
+    for (ABFLocationFetchRequest *fetchRequest in fetchRequests) {
+        NSUInteger requestCount = fetchRequest.fetchObjects.count;
         
-        // Create the dictionary for y values
-        if (!yDict) {
-            
-            yDict = [NSMutableDictionary dictionary];
-            
-            [clusterGrid setObject:yDict
-                            forKey:@(x)];
+        if (self.resultsLimit >= 0) {
+            requestCount = MIN(requestCount, (NSUInteger)self.resultsLimit);
         }
         
-        NSMutableArray *cluster = [yDict objectForKey:@(y)];
-        
-        if (!cluster) {
-            
-            cluster = [NSMutableArray array];
-            
-            [yDict setObject:cluster
-                      forKey:@(y)];
+        count += requestCount;
+    }
+    
+    return ABFEstimatedFetchSizeForObjectCount(count) > self.memoryBudget;
+}
+
+- (void)reduceMemoryUsage
+{
+    [self releaseCaches];
+    
+    [self updateMemoryUsage];
+}
+
+- (BOOL)performSplitFetchForRegion:(MKCoordinateRegion)region
+{
+    // The members of aggregate-only clusters are not known
+    if (_aggregateOnly) {
+        return NO;
+    }
+    
+    // Keep the members of the previous clusters within the region, in their fetched (sorted) order
+    NSMutableArray *safeObjects = [NSMutableArray arrayWithCapacity:_safeObjects.count];
+    
+    for (ABFLocationSafeRealmObject *safeObject in _safeObjects) {
+        if (ABFCoordinateRegionContainsCoordinate(region, safeObject.coordinate)) {
+            [safeObjects addObject:safeObject];
         }
-        
-        [cluster addObject:safeObject];
     }
     
-    // Create annotations from cluster array
-    _annotations = [self clusterAnnotationsFromClusterGrid:clusterGrid.copy];
+    _safeObjects = safeObjects.copy;
+    
+    _annotations = [self uniqueAnnotationsFromSafeObjects:_safeObjects];
+    
+    [self updateFetchMemoryUsage];
     
     return YES;
 }
@@ -473,6 +737,62 @@ ABFClusterSizeForZoomLevel ABFDefaultClusterSizeForZoomLevel()
     _fetchRequest = fetchRequest;
     _titleKeyPath = titleKeyPath;
     _subtitleKeyPath = subtitleKeyPath;
+    _layers = nil;
+    _layerFetchRequests = nil;
+    _layerControllers = nil;
+}
+
+- (void)updateLayers:(NSArray<ABFMapLayer *> *)layers
+       fetchRequests:(NSArray<ABFLocationFetchRequest *> *)fetchRequests
+{
+    if (layers.count == 0 ||
+        layers.count != fetchRequests.count) {
+        
+        @throw [NSException exceptionWithName:@"ABFException"
+                                       reason:@"Each layer must have one fetch request"
+                                     userInfo:nil];
+    }
+    
+    // Reuse the layer controllers while the number of layers is the same
+    NSMutableArray *layerControllers = [NSMutableArray arrayWithCapacity:layers.count];
+    
+    for (NSUInteger i = 0; i < layers.count; i++) {
+        ABFLocationFetchedResultsController *layerController =
+        i < self.layerControllers.count ? self.layerControllers[i] : [[ABFLocationFetchedResultsController alloc] init];
+        
+        [layerController updateLocationFetchRequest:fetchRequests[i]
+                                       titleKeyPath:layers[i].titleKeyPath
+                                    subtitleKeyPath:layers[i].subtitleKeyPath];
+        
+        [layerControllers addObject:layerController];
+    }
+    
+    _fetchRequest = fetchRequests.firstObject;
+    _layers = layers.copy;
+    _layerFetchRequests = fetchRequests.copy;
+    _layerControllers = layerControllers.copy;
+}
+
+- (void)replaceAnnotations:(NSSet<ABFAnnotation *> *)annotations
+  withDisplayedAnnotations:(NSSet<ABFAnnotation *> *)displayedAnnotations
+{
+    // A newer fetch owns the annotations now
+    if (_annotations != annotations) {
+        return;
+    }
+    
+    NSMutableArray *replacedAnnotations = [NSMutableArray array];
+    
+    for (ABFAnnotation *annotation in annotations) {
+        if ([displayedAnnotations member:annotation] != annotation) {
+            [replacedAnnotations addObject:annotation];
+        }
+    }
+    
+    // The replaced instances leave the annotations before they are reconfigured, so the set stays consistent
+    _annotations = displayedAnnotations.copy;
+    
+    [self recycleAnnotations:replacedAnnotations];
 }
 
 #pragma mark - Setters
@@ -491,20 +811,238 @@ ABFClusterSizeForZoomLevel ABFDefaultClusterSizeForZoomLevel()
 
 #pragma mark - Private Instance
 
-- (NSArray *)safeObjectsFromFetchResults:(id<RLMCollection>)fetchResults
+/**
+ *  Pools annotations that are no longer in annotations so the next fetch can reuse them
+ */
+- (void)recycleAnnotations:(NSArray<ABFAnnotation *> *)annotations
 {
-    NSMutableArray *safeObjects = [NSMutableArray arrayWithCapacity:fetchResults.count];
+    @synchronized(self.annotationPool) {
+        for (ABFAnnotation *annotation in annotations) {
+            if (self.annotationPool.count >= self.annotationPoolLimit) {
+                break;
+            }
+            
+            // Release the objects now rather than when the annotation is reused
+            [annotation prepareWithType:ABFAnnotationTypeUnique
+                             coordinate:kCLLocationCoordinate2DInvalid
+                            safeObjects:@[]
+                                  title:nil
+                               subtitle:nil
+               clusterTitleFormatString:nil];
+            
+            [self.annotationPool addObject:annotation];
+        }
+    }
+    
+    [self updateMemoryUsage];
+}
+
+- (NSArray *)fetchSafeObjects
+{
+    if (!self.layerControllers) {
+        return [self safeObjectsFromFetchResults:self.fetchRequest.fetchObjects];
+    }
+    
+    NSArray *layerControllers = self.layerControllers;
+    NSArray *layers = self.layers;
+    
+    NSUInteger layerCount = layerControllers.count;
+    
+    NSMutableArray *layerSafeObjects = [NSMutableArray arrayWithCapacity:layerCount];
+    
+    for (ABFLocationFetchedResultsController *layerController in layerControllers) {
+        layerController.sortDescriptor = self.sortDescriptor;
+        layerController.resultsLimit = self.resultsLimit;
+        
+        [layerSafeObjects addObject:@[]];
+    }
+    
+    __block NSException *layerException = nil;
+    
+    // Each layer fetches on its own thread with its own Realm instance
+    dispatch_apply(layerCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t i) {
+        @autoreleasepool {
+            @try {
+                ABFLocationFetchedResultsController *layerController = layerControllers[i];
+                
+                NSArray *safeObjects = [layerController safeObjectsFromFetchResults:layerController.fetchRequest.fetchObjects];
+                
+                NSString *layerIdentifier = ((ABFMapLayer *)layers[i]).identifier;
+                
+                for (ABFLocationSafeRealmObject *safeObject in safeObjects) {
+                    safeObject.layerIdentifier = layerIdentifier;
+                }
+                
+                @synchronized(layerSafeObjects) {
+                    layerSafeObjects[i] = safeObjects;
+                }
+            }
+            @catch (NSException *exception) {
+                @synchronized(layerSafeObjects) {
+                    layerException = exception;
+                }
+            }
+        }
+    });
+    
+    if (layerException) {
+        @throw layerException;
+    }
+    
+    NSMutableArray *safeObjects = [NSMutableArray array];
+    
+    for (NSArray *safeObjectsOfLayer in layerSafeObjects) {
+        [safeObjects addObjectsFromArray:safeObjectsOfLayer];
+    }
+    
+    // Each layer is sorted on its own
+    if (layerCount > 1) {
+        [self sortSafeObjects:safeObjects];
+    }
+    
+    return safeObjects.copy;
+}
+
+- (void)releaseCaches
+{
+    @synchronized(self.annotationPool) {
+        [self.annotationPool removeAllObjects];
+    }
+    
+    ABFArenaFree(&_clusterArena);
+}
+
+/**
+ *  Estimates the safe objects and annotations of the last fetch, then updates memoryUsage
+ */
+- (void)updateFetchMemoryUsage
+{
+    NSUInteger fetchMemoryUsage = 0;
+    
+    for (ABFLocationSafeRealmObject *safeObject in _safeObjects) {
+        fetchMemoryUsage += ABFEstimatedSizeOfSafeObject(safeObject);
+    }
+    
+    NSUInteger annotationSize = class_getInstanceSize([ABFAnnotation class]);
+    
+    for (ABFAnnotation *annotation in _annotations) {
+        fetchMemoryUsage += annotationSize + annotation.safeObjects.count * sizeof(id);
+    }
+    
+    _fetchMemoryUsage = fetchMemoryUsage;
+    
+    [self updateMemoryUsage];
+}
+
+- (void)updateMemoryUsage
+{
+    NSUInteger poolCount = 0;
+    
+    @synchronized(self.annotationPool) {
+        poolCount = self.annotationPool.count;
+    }
+    
+    NSUInteger cacheMemoryUsage = poolCount * class_getInstanceSize([ABFAnnotation class]) + _clusterArena.capacity;
+    
+    // Over budget, the caches go first
+    if (self.memoryBudget > 0 &&
+        cacheMemoryUsage > 0 &&
+        _fetchMemoryUsage + cacheMemoryUsage > self.memoryBudget) {
+        [self releaseCaches];
+        
+        cacheMemoryUsage = 0;
+    }
+    
+    self.memoryUsage = _fetchMemoryUsage + cacheMemoryUsage;
+}
+
+/**
+ *  Enumerates the fetch results the fetch request includes, up to the results limit.
+ *
+ *  Coordinates are read in batches so the fetch request evaluates them together; circle and polygon fetch requests only fetch a covering of their shape from Realm. Fetch requests that don't override evaluateCoordinates:count:results: skip the batching.
+ */
+- (void)enumerateFetchResults:(id<RLMCollection>)fetchResults
+                   usingBlock:(void (^)(RLMObject *object, NSUInteger index, CLLocationCoordinate2D coordinate))block
+{
+    ABFLocationFetchRequest *fetchRequest = self.fetchRequest;
+    
+    // The base fetch request includes every object, so a plain region fetch enumerates without batching
+    if ([fetchRequest methodForSelector:@selector(evaluateCoordinates:count:results:)] ==
+        [ABFLocationFetchRequest instanceMethodForSelector:@selector(evaluateCoordinates:count:results:)]) {
+        
+        NSUInteger index = 0;
+        
+        for (RLMObject *object in fetchResults) {
+            
+            if (index == self.resultsLimit) {
+                return;
+            }
+            
+            block(object, index, [self coordinateForObject:object]);
+            
+            index ++;
+        }
+        
+        return;
+    }
+    
+    NSUInteger resultsCount = fetchResults.count;
+    
+    NSMutableArray *batchObjects = [NSMutableArray arrayWithCapacity:ABFCoordinateBatchSize];
     
+    CLLocationCoordinate2D coordinates[ABFCoordinateBatchSize];
+    BOOL included[ABFCoordinateBatchSize];
+    
+    NSUInteger index = 0;
+    NSUInteger batchStart = 0;
     NSUInteger count = 0;
     
     for (RLMObject *object in fetchResults) {
         
-        if (count == self.resultsLimit) {
-            break;
+        coordinates[batchObjects.count] = [self coordinateForObject:object];
+        
+        [batchObjects addObject:object];
+        
+        index ++;
+        
+        // Evaluate full batches and the last one
+        if (batchObjects.count < ABFCoordinateBatchSize &&
+            index < resultsCount) {
+            continue;
         }
         
-        CLLocationCoordinate2D coordinate = [self coordinateForObject:object];
+        NSUInteger batchCount = batchObjects.count;
+        
+        [fetchRequest evaluateCoordinates:coordinates count:batchCount results:included];
         
+        for (NSUInteger i = 0; i < batchCount; i++) {
+            
+            if (!included[i]) {
+                continue;
+            }
+            
+            if (count == self.resultsLimit) {
+                return;
+            }
+            
+            block(batchObjects[i], batchStart + i, coordinates[i]);
+            
+            count ++;
+        }
+        
+        batchStart += batchCount;
+        
+        [batchObjects removeAllObjects];
+    }
+}
+
+- (NSArray *)safeObjectsFromFetchResults:(id<RLMCollection>)fetchResults
+{
+    NSMutableArray *safeObjects = [NSMutableArray arrayWithCapacity:fetchResults.count];
+    
+    [self enumerateFetchResults:fetchResults usingBlock:^(RLMObject *object,
+                                                          NSUInteger index,
+                                                          CLLocationCoordinate2D coordinate) {
         NSString *title = [self titleForObject:object];
         
         NSString *subtitle = [self subtitleForObject:object];
@@ -525,10 +1063,15 @@ ABFClusterSizeForZoomLevel ABFDefaultClusterSizeForZoomLevel()
         }
         
         [safeObjects addObject:safeObject];
-        
-        count ++;
-    }
+    }];
     
+    [self sortSafeObjects:safeObjects];
+    
+    return safeObjects.copy;
+}
+
+- (void)sortSafeObjects:(NSMutableArray *)safeObjects
+{
     if (self.sortDescriptor) {
         
         BOOL nearestFirst = self.sortDescriptor.nearestFirst;
@@ -544,23 +1087,56 @@ ABFClusterSizeForZoomLevel ABFDefaultClusterSizeForZoomLevel()
             return [@(obj1.currentDistance) compare:@(obj2.currentDistance)];
         }];
     }
+}
+
+- (ABFAnnotation *)dequeueAnnotation
+{
+    ABFAnnotation *annotation = nil;
+    
+    @synchronized(self.annotationPool) {
+        annotation = self.annotationPool.lastObject;
+        
+        if (annotation) {
+            [self.annotationPool removeLastObject];
+        }
+    }
     
-    return safeObjects.copy;
+    if (annotation) {
+        _reusedAnnotationCount ++;
+        
+        return annotation;
+    }
+    
+    _allocatedAnnotationCount ++;
+    
+    return [[ABFAnnotation alloc] init];
+}
+
+- (void)resetAllocationCounts
+{
+    _allocatedAnnotationCount = 0;
+    _reusedAnnotationCount = 0;
+    _allocatedContainerCount = 0;
 }
 
 - (NSSet *)uniqueAnnotationsFromSafeObjects:(NSArray *)safeObjects
 {
+    [self resetAllocationCounts];
+    
     NSMutableSet *annotations = [NSMutableSet setWithCapacity:safeObjects.count];
     
     for (ABFLocationSafeRealmObject *safeObject in safeObjects) {
         
-        ABFAnnotation *annotation = [ABFAnnotation annotationWithType:ABFAnnotationTypeUnique];
+        ABFAnnotation *annotation = [self dequeueAnnotation];
         
-        [annotation setTitle:safeObject.title];
-        [annotation setSubtitle:safeObject.subtitle];
-        [annotation setCoordinate:safeObject.coordinate];
+        _allocatedContainerCount ++;
         
-        [annotation addSafeObject:safeObject];
+        [annotation prepareWithType:ABFAnnotationTypeUnique
+                         coordinate:safeObject.coordinate
+                        safeObjects:@[safeObject]
+                              title:safeObject.title
+                           subtitle:safeObject.subtitle
+           clusterTitleFormatString:nil];
         
         [annotations addObject:annotation];
     }
@@ -568,70 +1144,404 @@ ABFClusterSizeForZoomLevel ABFDefaultClusterSizeForZoomLevel()
     return annotations.copy;
 }
 
-- (NSSet *)clusterAnnotationsFromClusterGrid:(NSDictionary *)clusterGrid
+- (NSSet *)clusterAnnotationsFromSafeObjects:(NSArray *)safeObjects
+                                 scaleFactor:(double)scaleFactor
 {
+    [self resetAllocationCounts];
+    
+    NSUInteger count = safeObjects.count;
+    
+    ABFArenaReset(&_clusterArena, count * (sizeof(ABFClusterCell) + sizeof(id)) + 32);
+    
+    ABFClusterCell *cells = ABFArenaAlloc(&_clusterArena, count * sizeof(ABFClusterCell));
+    __unsafe_unretained id *clusterObjects = (__unsafe_unretained id *)ABFArenaAlloc(&_clusterArena, count * sizeof(id));
+    
+    if (count > 0 &&
+        (!cells || !clusterObjects)) {
+        @throw [NSException exceptionWithName:@"ABFException"
+                                       reason:@"Unable to allocate memory for clustering"
+                                     userInfo:nil];
+    }
+    
+    // Place safe objects into the cluster grid
+    NSUInteger index = 0;
+    
+    for (ABFLocationSafeRealmObject *safeObject in safeObjects) {
+        
+        CLLocationCoordinate2D coordinate = safeObject.coordinate;
+        
+        MKMapPoint safeObjectPoint = MKMapPointForCoordinate(coordinate);
+        
+        // Get x/y values adjusted for scale factor
+        uint64_t x = (uint64_t)floor(safeObjectPoint.x * scaleFactor);
+        uint64_t y = (uint64_t)floor(safeObjectPoint.y * scaleFactor);
+        
+        cells[index].key = (x << 32) | (y & 0xFFFFFFFF);
+        cells[index].index = index;
+        cells[index].coordinate = coordinate;
+        
+        index ++;
+    }
+    
+    // Group the objects of each grid cell together
+    qsort(cells, count, sizeof(ABFClusterCell), ABFClusterCellCompare);
+    
     NSMutableSet *annotations = [NSMutableSet set];
     
-    for (NSNumber *xKey in clusterGrid) {
+    NSString *clusterTitleFormatString = self.clusterTitleFormatString;
+    
+    NSUInteger start = 0;
+    
+    while (start < count) {
         
-        NSDictionary *yDict = [clusterGrid objectForKey:xKey];
+        NSUInteger end = start;
         
-        for (NSNumber *yKey in yDict) {
-            
-            NSArray *cluster = [yDict objectForKey:yKey];
+        double totalLat = 0;
+        double totalLong = 0;
+        
+        while (end < count &&
+               cells[end].key == cells[start].key) {
             
-            ABFAnnotation *annotation;
+            totalLat += cells[end].coordinate.latitude;
+            totalLong += cells[end].coordinate.longitude;
             
-            if (cluster.count > 1) {
-                annotation = [ABFAnnotation annotationWithType:ABFAnnotationTypeCluster];
-            }
-            else {
-                annotation = [ABFAnnotation annotationWithType:ABFAnnotationTypeUnique];
-            }
+            clusterObjects[end - start] = safeObjects[cells[end].index];
             
-            NSUInteger clusterCount = cluster.count;
+            end ++;
+        }
+        
+        NSUInteger clusterCount = end - start;
+        
+        // Get the average lat/long for the cluster coordinate
+        CLLocationCoordinate2D annotationCoordinate = CLLocationCoordinate2DMake(totalLat/clusterCount,
+                                                                                 totalLong/clusterCount);
+        
+        NSArray *cluster = [NSArray arrayWithObjects:clusterObjects count:clusterCount];
+        
+        _allocatedContainerCount ++;
+        
+        ABFAnnotation *annotation = [self dequeueAnnotation];
+        
+        if (clusterCount > 1) {
+            [annotation prepareWithType:ABFAnnotationTypeCluster
+                             coordinate:annotationCoordinate
+                            safeObjects:cluster
+                                  title:nil
+                               subtitle:nil
+               clusterTitleFormatString:clusterTitleFormatString];
             
-            NSString *title = @"";
+            if (self.layerControllers) {
+                annotation.objectCountsByLayer = [self objectCountsByLayerForSafeObjects:cluster];
+                
+                _allocatedContainerCount ++;
+            }
+        }
+        else {
+            ABFLocationSafeRealmObject *safeObject = cluster.firstObject;
             
-            if (clusterCount > 1) {
-                NSString *countString = [NSString stringWithFormat:@"%lu",(unsigned long)clusterCount];
+            [annotation prepareWithType:ABFAnnotationTypeUnique
+                             coordinate:annotationCoordinate
+                            safeObjects:cluster
+                                  title:safeObject.title
+                               subtitle:safeObject.subtitle
+               clusterTitleFormatString:nil];
+        }
+        
+        [annotations addObject:annotation];
+        
+        start = end;
+    }
+    
+    return annotations.copy;
+}
+
+- (NSDictionary *)objectCountsByLayerForSafeObjects:(NSArray *)safeObjects
+{
+    NSCountedSet *layerIdentifiers = [[NSCountedSet alloc] init];
+    
+    for (ABFLocationSafeRealmObject *safeObject in safeObjects) {
+        if (safeObject.layerIdentifier) {
+            [layerIdentifiers addObject:safeObject.layerIdentifier];
+        }
+    }
+    
+    NSMutableDictionary *objectCountsByLayer = [NSMutableDictionary dictionaryWithCapacity:layerIdentifiers.count];
+    
+    for (NSString *layerIdentifier in layerIdentifiers) {
+        objectCountsByLayer[layerIdentifier] = @([layerIdentifiers countForObject:layerIdentifier]);
+    }
+    
+    return objectCountsByLayer.copy;
+}
+
+- (NSSet *)aggregateClusterAnnotationsWithScaleFactor:(double)scaleFactor
+{
+    [self resetAllocationCounts];
+    
+    // A single fetch is aggregated as one layer
+    NSArray *sources = self.layerControllers ? self.layerControllers : @[self];
+    
+    NSUInteger sourceCount = sources.count;
+    
+    for (ABFLocationFetchedResultsController *layerController in self.layerControllers) {
+        layerController.resultsLimit = self.resultsLimit;
+    }
+    
+    ABFClusterAggregateTable *tables = calloc(sourceCount, sizeof(ABFClusterAggregateTable));
+    
+    if (!tables) {
+        @throw [NSException exceptionWithName:@"ABFException"
+                                       reason:@"Unable to allocate memory for clustering"
+                                     userInfo:nil];
+    }
+    
+    NSMutableArray *sourceSingleObjects = [NSMutableArray arrayWithCapacity:sourceCount];
+    
+    for (NSUInteger i = 0; i < sourceCount; i++) {
+        [sourceSingleObjects addObject:@{}];
+    }
+    
+    __block NSException *sourceException = nil;
+    
+    // Each layer aggregates on its own thread with its own Realm instance
+    dispatch_apply(sourceCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t i) {
+        @autoreleasepool {
+            @try {
+                ABFLocationFetchedResultsController *source = sources[i];
                 
-                title = [self.clusterTitleFormatString stringByReplacingOccurrencesOfString:@"$OBJECTSCOUNT" withString:countString];
+                id<RLMCollection> fetchResults = source.fetchRequest.fetchObjects;
+                
+                [source aggregateFetchResults:fetchResults
+                                  scaleFactor:scaleFactor
+                                        layer:i
+                                      inTable:&tables[i]];
+                
+                // Safe objects can only be created on the thread of the results
+                NSDictionary *singleObjects = [source singleObjectsForAggregateTable:&tables[i]
+                                                                        fetchResults:fetchResults];
+                
+                @synchronized(sourceSingleObjects) {
+                    sourceSingleObjects[i] = singleObjects;
+                }
             }
-            else {
-                ABFLocationSafeRealmObject *safeObject = cluster.firstObject;
+            @catch (NSException *exception) {
+                @synchronized(sourceSingleObjects) {
+                    sourceException = exception;
+                }
+            }
+        }
+    });
+    
+    // A single fetch uses its table directly
+    ABFClusterAggregateTable table = self.layerControllers ? (ABFClusterAggregateTable){NULL, 0, 0} : tables[0];
+    
+    // Object count of each layer for each slot of the combined table, sourceCount counts per slot
+    size_t *layerCounts = NULL;
+    
+    BOOL merged = YES;
+    
+    if (!sourceException &&
+        self.layerControllers) {
+        NSUInteger layerCellCount = 0;
+        
+        for (NSUInteger layer = 0; layer < sourceCount; layer++) {
+            layerCellCount += tables[layer].cellCount;
+        }
+        
+        // Sized for every layer cell, so merging never grows the table and the slots stay put
+        merged = ABFClusterAggregateTableInit(&table, layerCellCount * 2);
+        
+        if (merged) {
+            layerCounts = calloc(table.capacity * sourceCount, sizeof(size_t));
+            
+            merged = layerCounts != NULL;
+        }
+        
+        // Combine the cells of the layers, keeping the count of each layer
+        for (NSUInteger layer = 0; merged && layer < sourceCount; layer++) {
+            for (NSUInteger slot = 0; slot < tables[layer].capacity; slot++) {
+                const ABFClusterAggregate *layerAggregate = &tables[layer].cells[slot];
+                
+                if (layerAggregate->count == 0) {
+                    continue;
+                }
+                
+                ABFClusterAggregate *aggregate = ABFClusterAggregateMerge(&table, layerAggregate);
+                
+                if (!aggregate) {
+                    merged = NO;
+                    
+                    break;
+                }
                 
-                title = safeObject.title;
-                [annotation setSubtitle:safeObject.subtitle];
+                layerCounts[(aggregate - table.cells) * sourceCount + layer] = layerAggregate->count;
             }
+        }
+    }
+    
+    if (self.layerControllers) {
+        for (NSUInteger i = 0; i < sourceCount; i++) {
+            ABFClusterAggregateTableFree(&tables[i]);
+        }
+    }
+    
+    free(tables);
+    
+    if (sourceException) {
+        ABFClusterAggregateTableFree(&table);
+        
+        @throw sourceException;
+    }
+    
+    if (!merged) {
+        ABFClusterAggregateTableFree(&table);
+        free(layerCounts);
+        
+        @throw [NSException exceptionWithName:@"ABFException"
+                                       reason:@"Unable to allocate memory for clustering"
+                                     userInfo:nil];
+    }
+    
+    NSMutableSet *annotations = [NSMutableSet set];
+    NSMutableArray *safeObjects = [NSMutableArray array];
+    
+    NSString *clusterTitleFormatString = self.clusterTitleFormatString;
+    
+    for (NSUInteger slot = 0; slot < table.capacity; slot++) {
+        ABFClusterAggregate aggregate = table.cells[slot];
+        
+        if (aggregate.count == 0) {
+            continue;
+        }
+        
+        // Get the average lat/long for the cluster coordinate
+        CLLocationCoordinate2D annotationCoordinate = CLLocationCoordinate2DMake(aggregate.totalLatitude/aggregate.count,
+                                                                                 aggregate.totalLongitude/aggregate.count);
+        
+        ABFAnnotation *annotation = [self dequeueAnnotation];
+        
+        if (aggregate.count > 1) {
+            [annotation prepareAggregateClusterWithCoordinate:annotationCoordinate
+                                                  objectCount:aggregate.count
+                                     clusterTitleFormatString:clusterTitleFormatString];
             
-            [annotation setTitle:title];
+            annotation.objectCountsByLayer = layerCounts ? [self objectCountsByLayerForLayerCounts:&layerCounts[slot * sourceCount]] : nil;
             
-            double totalLat = 0;
-            double totalLong = 0;
+            _allocatedContainerCount ++;
+        }
+        else {
+            ABFLocationSafeRealmObject *safeObject = sourceSingleObjects[aggregate.layer][@(aggregate.key)];
             
-            for (ABFLocationSafeRealmObject *safeObject in cluster) {
-                totalLat += safeObject.coordinate.latitude;
-                totalLong += safeObject.coordinate.longitude;
-                
-                [annotation addSafeObject:safeObject];
+            if (self.layerControllers) {
+                safeObject.layerIdentifier = self.layers[aggregate.layer].identifier;
             }
             
-            // Get the average lat/long for the cluster coordinate
-            CLLocationDegrees annotationLat = totalLat/clusterCount;
-            CLLocationDegrees annotationLong = totalLong/clusterCount;
-            
-            CLLocationCoordinate2D annotationCoordinate = CLLocationCoordinate2DMake(annotationLat, annotationLong);
+            [safeObjects addObject:safeObject];
             
-            [annotation setCoordinate:annotationCoordinate];
+            _allocatedContainerCount ++;
             
-            [annotations addObject:annotation];
+            [annotation prepareWithType:ABFAnnotationTypeUnique
+                             coordinate:annotationCoordinate
+                            safeObjects:@[safeObject]
+                                  title:safeObject.title
+                               subtitle:safeObject.subtitle
+               clusterTitleFormatString:nil];
         }
+        
+        [annotations addObject:annotation];
     }
     
+    ABFClusterAggregateTableFree(&table);
+    free(layerCounts);
+    
+    _safeObjects = safeObjects.copy;
+    
     return annotations.copy;
 }
 
+/**
+ *  Object counts keyed by layer identifier for the layers with objects in a cell
+ */
+- (NSDictionary *)objectCountsByLayerForLayerCounts:(const size_t *)layerCounts
+{
+    NSMutableDictionary *objectCountsByLayer = [NSMutableDictionary dictionary];
+    
+    NSArray<ABFMapLayer *> *layers = self.layers;
+    
+    for (NSUInteger layer = 0; layer < layers.count; layer++) {
+        if (layerCounts[layer] > 0) {
+            objectCountsByLayer[layers[layer].identifier] = @(layerCounts[layer]);
+        }
+    }
+    
+    return objectCountsByLayer.copy;
+}
+
+/**
+ *  Accumulates the fetch results into a new table of cluster cells, free the table with ABFClusterAggregateTableFree()
+ */
+- (void)aggregateFetchResults:(id<RLMCollection>)fetchResults
+                  scaleFactor:(double)scaleFactor
+                        layer:(NSUInteger)layer
+                      inTable:(ABFClusterAggregateTable *)table
+{
+    if (!ABFClusterAggregateTableInit(table, 1024)) {
+        @throw [NSException exceptionWithName:@"ABFException"
+                                       reason:@"Unable to allocate memory for clustering"
+                                     userInfo:nil];
+    }
+    
+    @try {
+        [self enumerateFetchResults:fetchResults usingBlock:^(RLMObject *object,
+                                                              NSUInteger index,
+                                                              CLLocationCoordinate2D coordinate) {
+            MKMapPoint point = MKMapPointForCoordinate(coordinate);
+            
+            uint64_t key = ABFClusterAggregateKey(point.x, point.y, scaleFactor);
+            
+            if (!ABFClusterAggregateAdd(table, key, index, layer, coordinate.latitude, coordinate.longitude)) {
+                @throw [NSException exceptionWithName:@"ABFException"
+                                               reason:@"Unable to allocate memory for clustering"
+                                             userInfo:nil];
+            }
+        }];
+    }
+    @catch (NSException *exception) {
+        ABFClusterAggregateTableFree(table);
+        
+        @throw exception;
+    }
+}
+
+/**
+ *  Creates safe objects for the cells with a single object, keyed by cell key
+ */
+- (NSDictionary *)singleObjectsForAggregateTable:(const ABFClusterAggregateTable *)table
+                                    fetchResults:(id<RLMCollection>)fetchResults
+{
+    NSMutableDictionary *singleObjects = [NSMutableDictionary dictionary];
+    
+    for (NSUInteger slot = 0; slot < table->capacity; slot++) {
+        ABFClusterAggregate aggregate = table->cells[slot];
+        
+        if (aggregate.count != 1) {
+            continue;
+        }
+        
+        RLMObject *object = [fetchResults objectAtIndex:aggregate.index];
+        
+        CLLocationCoordinate2D coordinate = CLLocationCoordinate2DMake(aggregate.totalLatitude,
+                                                                       aggregate.totalLongitude);
+        
+        singleObjects[@(aggregate.key)] = [ABFLocationSafeRealmObject safeLocationObjectFromObject:object
+                                                                                        coordinate:coordinate
+                                                                                             title:[self titleForObject:object]
+                                                                                          subtitle:[self subtitleForObject:object]];
+    }
+    
+    return singleObjects.copy;
+}
+
 - (CLLocationCoordinate2D)coordinateForObject:(RLMObject *)object
 {
     CLLocationDegrees latitude = 0;
@@ -0,0 +1,78 @@
+//
+//  ABFLocationShapeFetchRequest.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#import "ABFLocationFetchRequest.h"
+
+/**
+ *  Location fetch request for the Realm objects within a radius of a center coordinate.
+ *
+ *  Realm is queried for a covering of coordinate regions (latitude bands as wide as the circle, see ABFCoveringRegionsForCircle), then evaluateCoordinates:count:results: keeps the coordinates within the great-circle distance. The region is the bounding region of the circle.
+ */
+@interface ABFCircleLocationFetchRequest : ABFLocationFetchRequest
+
+/**
+ *  Center of the circle
+ */
+@property (nonatomic, readonly) CLLocationCoordinate2D center;
+
+/**
+ *  Radius of the circle in meters
+ */
+@property (nonatomic, readonly) CLLocationDistance radius;
+
+/**
+ *  Creates a ABFCircleLocationFetchRequest instance that fetches the objects within a radius of a center coordinate.
+ *
+ *  @param entityName       the Realm object name (class name)
+ *  @param realm            the RLMRealm in which the entity(s) exist
+ *  @param latitudeKeyPath  the latitude key path for the value to test the distance against
+ *  @param longitudeKeyPath the longitude key path for the value to test the distance against
+ *  @param center           the center of the circle
+ *  @param radius           the radius of the circle in meters
+ *
+ *  @return an instance of ABFCircleLocationFetchRequest that contains the NSPredicate for the covering of the circle
+ */
++ (nonnull instancetype)locationFetchRequestWithEntityName:(nonnull NSString *)entityName
+                                                   inRealm:(nonnull RLMRealm *)realm
+                                           latitudeKeyPath:(nonnull NSString *)latitudeKeyPath
+                                          longitudeKeyPath:(nonnull NSString *)longitudeKeyPath
+                                                    center:(CLLocationCoordinate2D)center
+                                                    radius:(CLLocationDistance)radius;
+
+@end
+
+/**
+ *  Location fetch request for the Realm objects inside a polygon.
+ *
+ *  Realm is queried for a covering of coordinate regions (latitude bands as wide as the polygon, see ABFCoveringRegionsForPolygon), then evaluateCoordinates:count:results: keeps the coordinates inside the polygon. Interior polygons are holes. Polygons can cross the -180/180 longitude meridian but not contain a pole. The region is the bounding region of the polygon.
+ */
+@interface ABFPolygonLocationFetchRequest : ABFLocationFetchRequest
+
+/**
+ *  The polygon that defines the fetch boundaries
+ */
+@property (nonatomic, readonly, nonnull) MKPolygon *polygon;
+
+/**
+ *  Creates a ABFPolygonLocationFetchRequest instance that fetches the objects inside a polygon.
+ *
+ *  @param entityName       the Realm object name (class name)
+ *  @param realm            the RLMRealm in which the entity(s) exist
+ *  @param latitudeKeyPath  the latitude key path for the value to test the polygon against
+ *  @param longitudeKeyPath the longitude key path for the value to test the polygon against
+ *  @param polygon          the polygon, with edges as straight lines in latitude/longitude
+ *
+ *  @return an instance of ABFPolygonLocationFetchRequest that contains the NSPredicate for the covering of the polygon
+ */
++ (nonnull instancetype)locationFetchRequestWithEntityName:(nonnull NSString *)entityName
+                                                   inRealm:(nonnull RLMRealm *)realm
+                                           latitudeKeyPath:(nonnull NSString *)latitudeKeyPath
+                                          longitudeKeyPath:(nonnull NSString *)longitudeKeyPath
+                                                   polygon:(nonnull MKPolygon *)polygon;
+
+@end
@@ -0,0 +1,191 @@
+//
+//  ABFLocationShapeFetchRequest.m
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#import "ABFLocationShapeFetchRequest.h"
+#import "ABFGeometry.h"
+
+#pragma mark - Private Functions
+
+static BOOL ABFFetchRequestEvaluateObjectCoordinate(ABFLocationFetchRequest *fetchRequest, RLMObject *object)
+{
+    CLLocationDegrees latitude = ((NSNumber *)[object valueForKeyPath:fetchRequest.latitudeKeyPath]).doubleValue;
+    CLLocationDegrees longitude = ((NSNumber *)[object valueForKeyPath:fetchRequest.longitudeKeyPath]).doubleValue;
+    
+    CLLocationCoordinate2D coordinate = CLLocationCoordinate2DMake(latitude, longitude);
+    
+    BOOL result = NO;
+    
+    [fetchRequest evaluateCoordinates:&coordinate count:1 results:&result];
+    
+    return result;
+}
+
+#pragma mark - ABFCircleLocationFetchRequest
+
+@implementation ABFCircleLocationFetchRequest
+
++ (instancetype)locationFetchRequestWithEntityName:(NSString *)entityName
+                                           inRealm:(RLMRealm *)realm
+                                   latitudeKeyPath:(NSString *)latitudeKeyPath
+                                  longitudeKeyPath:(NSString *)longitudeKeyPath
+                                            center:(CLLocationCoordinate2D)center
+                                            radius:(CLLocationDistance)radius
+{
+    MKCoordinateRegion boundingRegion;
+    ABFCoveringRegionsForCircle(center, radius, 1, &boundingRegion);
+    
+    ABFCircleLocationFetchRequest *fetchRequest = [[self alloc] initWithEntityName:entityName
+                                                                           inRealm:realm
+                                                                   latitudeKeyPath:latitudeKeyPath
+                                                                  longitudeKeyPath:longitudeKeyPath
+                                                                         forRegion:boundingRegion];
+    
+    fetchRequest->_center = center;
+    fetchRequest->_radius = radius;
+    
+    // Coarse filter, the exact distance is evaluated on the fetched coordinates
+    MKCoordinateRegion coveringRegions[ABFDefaultCoveringBandCount];
+    
+    NSUInteger coveringCount = ABFCoveringRegionsForCircle(center, radius, ABFDefaultCoveringBandCount, coveringRegions);
+    
+    fetchRequest.predicate = NSPredicateForCoordinateRegions(coveringRegions, coveringCount, latitudeKeyPath, longitudeKeyPath);
+    
+    return fetchRequest;
+}
+
+#pragma mark - Public Instance
+
+- (BOOL)evaluateObject:(RLMObject *)object
+{
+    return ([super evaluateObject:object] &&
+            ABFFetchRequestEvaluateObjectCoordinate(self, object));
+}
+
+- (void)evaluateCoordinates:(const CLLocationCoordinate2D *)coordinates
+                      count:(NSUInteger)count
+                    results:(BOOL *)results
+{
+    ABFCircleContainsCoordinates(self.center, self.radius, coordinates, count, results);
+}
+
+@end
+
+#pragma mark - ABFPolygonLocationFetchRequest
+
+@interface ABFPolygonLocationFetchRequest ()
+
+/**
+ *  The CLLocationCoordinate2D vertices of the polygon and its interior polygons, unwrapped into the longitude frame of the polygon
+ */
+@property (nonatomic, strong) NSData *vertexData;
+
+/**
+ *  The NSUInteger number of vertices of each ring in vertexData, outer ring first
+ */
+@property (nonatomic, strong) NSData *ringCountData;
+
+@end
+
+@implementation ABFPolygonLocationFetchRequest
+
++ (instancetype)locationFetchRequestWithEntityName:(NSString *)entityName
+                                           inRealm:(RLMRealm *)realm
+                                   latitudeKeyPath:(NSString *)latitudeKeyPath
+                                  longitudeKeyPath:(NSString *)longitudeKeyPath
+                                           polygon:(MKPolygon *)polygon
+{
+    NSArray<MKPolygon *> *rings = [@[polygon] arrayByAddingObjectsFromArray:polygon.interiorPolygons ? polygon.interiorPolygons : @[]];
+    
+    NSUInteger vertexCount = 0;
+    
+    for (MKPolygon *ring in rings) {
+        vertexCount += ring.pointCount;
+    }
+    
+    NSMutableData *vertexData = [NSMutableData dataWithLength:vertexCount * sizeof(CLLocationCoordinate2D)];
+    NSMutableData *ringCountData = [NSMutableData dataWithLength:rings.count * sizeof(NSUInteger)];
+    
+    CLLocationCoordinate2D *vertices = vertexData.mutableBytes;
+    NSUInteger *ringCounts = ringCountData.mutableBytes;
+    
+    NSUInteger ringStart = 0;
+    
+    // Interior rings are unwrapped against the middle of the outer ring
+    CLLocationDegrees referenceLongitude = 0;
+    
+    for (NSUInteger i = 0; i < rings.count; i++) {
+        MKPolygon *ring = rings[i];
+        
+        [ring getCoordinates:vertices + ringStart range:NSMakeRange(0, ring.pointCount)];
+        
+        if (i == 0 &&
+            ring.pointCount > 0) {
+            ABFUnwrapLongitudes(vertices, ring.pointCount, vertices[0].longitude);
+            
+            CLLocationDegrees minLongitude = vertices[0].longitude;
+            CLLocationDegrees maxLongitude = vertices[0].longitude;
+            
+            for (NSUInteger j = 1; j < ring.pointCount; j++) {
+                minLongitude = MIN(minLongitude, vertices[j].longitude);
+                maxLongitude = MAX(maxLongitude, vertices[j].longitude);
+            }
+            
+            referenceLongitude = (minLongitude + maxLongitude) / 2;
+        }
+        else {
+            ABFUnwrapLongitudes(vertices + ringStart, ring.pointCount, referenceLongitude);
+        }
+        
+        ringCounts[i] = ring.pointCount;
+        ringStart += ring.pointCount;
+    }
+    
+    MKCoordinateRegion boundingRegion = MKCoordinateRegionMake(polygon.coordinate, MKCoordinateSpanMake(0, 0));
+    ABFCoveringRegionsForPolygon(vertices, ringCounts[0], 1, &boundingRegion);
+    
+    ABFPolygonLocationFetchRequest *fetchRequest = [[self alloc] initWithEntityName:entityName
+                                                                            inRealm:realm
+                                                                    latitudeKeyPath:latitudeKeyPath
+                                                                   longitudeKeyPath:longitudeKeyPath
+                                                                          forRegion:boundingRegion];
+    
+    fetchRequest->_polygon = polygon;
+    fetchRequest.vertexData = vertexData.copy;
+    fetchRequest.ringCountData = ringCountData.copy;
+    
+    // Coarse filter, the polygon is evaluated on the fetched coordinates
+    MKCoordinateRegion coveringRegions[ABFDefaultCoveringBandCount];
+    
+    NSUInteger coveringCount = ABFCoveringRegionsForPolygon(vertices, ringCounts[0], ABFDefaultCoveringBandCount, coveringRegions);
+    
+    fetchRequest.predicate = NSPredicateForCoordinateRegions(coveringRegions, coveringCount, latitudeKeyPath, longitudeKeyPath);
+    
+    return fetchRequest;
+}
+
+#pragma mark - Public Instance
+
+- (BOOL)evaluateObject:(RLMObject *)object
+{
+    return ([super evaluateObject:object] &&
+            ABFFetchRequestEvaluateObjectCoordinate(self, object));
+}
+
+- (void)evaluateCoordinates:(const CLLocationCoordinate2D *)coordinates
+                      count:(NSUInteger)count
+                    results:(BOOL *)results
+{
+    ABFPolygonContainsCoordinates(self.vertexData.bytes,
+                                  self.ringCountData.bytes,
+                                  self.ringCountData.length / sizeof(NSUInteger),
+                                  coordinates,
+                                  count,
+                                  results);
+}
+
+@end
@@ -0,0 +1,92 @@
+//
+//  ABFMapLayer.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+@import MapKit;
+
+/**
+ *  Configuration and style for one layer of objects on a map.
+ *
+ *  Assign several layers to ABFMapRefreshPipeline layers (or ABFRealmMapView layers) to display different entities, or the same entity with different predicates, on one map. Each refresh fetches the layers concurrently and clusters their objects together; clusters report how many objects of each layer they contain.
+ */
+@interface ABFMapLayer : NSObject
+
+/**
+ *  Identifies the layer in the annotations, must be unique among the layers of a map
+ *
+ *  @see ABFAnnotation layerIdentifier
+ */
+@property (nonatomic, readonly, nonnull) NSString *identifier;
+
+/**
+ *  The Realm object's name being fetched for the layer
+ */
+@property (nonatomic, readonly, nonnull) NSString *entityName;
+
+/**
+ *  The key path on fetched Realm objects for the latitude value
+ */
+@property (nonatomic, readonly, nonnull) NSString *latitudeKeyPath;
+
+/**
+ *  The key path on fetched Realm objects for the longitude value
+ */
+@property (nonatomic, readonly, nonnull) NSString *longitudeKeyPath;
+
+/**
+ *  The key path on fetched Realm objects for the title of the annotation view
+ */
+@property (nonatomic, strong, nullable) NSString *titleKeyPath;
+
+/**
+ *  The key path on fetched Realm objects for the subtitle of the annotation view
+ */
+@property (nonatomic, strong, nullable) NSString *subtitleKeyPath;
+
+/**
+ *  Predicate included, via AND, along with the generated predicate for the location bounding box.
+ */
+@property (nonatomic, strong, nullable) NSPredicate *basePredicate;
+
+/**
+ *  The color of the annotation views for the layer. Clusters use the color of the layer with the most objects in the cluster.
+ *
+ *  Default is nil (the ABFClusterAnnotationView default color)
+ */
+@property (nonatomic, strong, nullable) UIColor *color;
+
+/**
+ *  Creates a map layer
+ *
+ *  @param identifier       unique identifier of the layer
+ *  @param entityName       the Realm object name (class name)
+ *  @param latitudeKeyPath  the key path on the Realm objects for the latitude value
+ *  @param longitudeKeyPath the key path on the Realm objects for the longitude value
+ *
+ *  @return instance of ABFMapLayer
+ */
++ (nonnull instancetype)layerWithIdentifier:(nonnull NSString *)identifier
+                                 entityName:(nonnull NSString *)entityName
+                            latitudeKeyPath:(nonnull NSString *)latitudeKeyPath
+                           longitudeKeyPath:(nonnull NSString *)longitudeKeyPath;
+
+/**
+ *  Creates a map layer
+ *
+ *  @param identifier       unique identifier of the layer
+ *  @param entityName       the Realm object name (class name)
+ *  @param latitudeKeyPath  the key path on the Realm objects for the latitude value
+ *  @param longitudeKeyPath the key path on the Realm objects for the longitude value
+ *
+ *  @return instance of ABFMapLayer
+ */
+- (nonnull instancetype)initWithIdentifier:(nonnull NSString *)identifier
+                                entityName:(nonnull NSString *)entityName
+                           latitudeKeyPath:(nonnull NSString *)latitudeKeyPath
+                          longitudeKeyPath:(nonnull NSString *)longitudeKeyPath;
+
+@end
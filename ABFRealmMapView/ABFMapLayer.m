@@ -0,0 +1,54 @@
+//
+//  ABFMapLayer.m
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#import "ABFMapLayer.h"
+
+@implementation ABFMapLayer
+
+#pragma mark - Public Class
+
++ (instancetype)layerWithIdentifier:(NSString *)identifier
+                         entityName:(NSString *)entityName
+                    latitudeKeyPath:(NSString *)latitudeKeyPath
+                   longitudeKeyPath:(NSString *)longitudeKeyPath
+{
+    return [[self alloc] initWithIdentifier:identifier
+                                 entityName:entityName
+                            latitudeKeyPath:latitudeKeyPath
+                           longitudeKeyPath:longitudeKeyPath];
+}
+
+#pragma mark - Public Instance
+
+- (instancetype)initWithIdentifier:(NSString *)identifier
+                        entityName:(NSString *)entityName
+                   latitudeKeyPath:(NSString *)latitudeKeyPath
+                  longitudeKeyPath:(NSString *)longitudeKeyPath
+{
+    self = [super init];
+    
+    if (self) {
+        _identifier = identifier;
+        _entityName = entityName;
+        _latitudeKeyPath = latitudeKeyPath;
+        _longitudeKeyPath = longitudeKeyPath;
+    }
+    
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> %@ (%@)",
+            NSStringFromClass([self class]),
+            self,
+            self.identifier,
+            self.entityName];
+}
+
+@end
@@ -0,0 +1,305 @@
+//
+//  ABFMapRefreshPipeline.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#import "ABFLocationFetchedResultsController.h"
+#import "ABFHeatMapTileOverlay.h"
+#import "ABFRefreshTrace.h"
+
+@import MapKit;
+
+#if __has_include(<RealmMapView/RealmMapView.h>)
+@import Realm;
+#else
+#import <Realm/Realm.h>
+#endif
+
+/**
+ *  Timings and counts collected for a single map refresh.
+ */
+@interface ABFRefreshMetrics : NSObject
+
+/**
+ *  Time spent performing the fetch (and clustering, if clustered) in the fetched results controller.
+ */
+@property (nonatomic, readonly) NSTimeInterval fetchDuration;
+
+/**
+ *  Time spent computing the annotations to add and remove.
+ */
+@property (nonatomic, readonly) NSTimeInterval diffDuration;
+
+/**
+ *  Time spent on the main thread adding and removing annotations on the map view.
+ */
+@property (nonatomic, readonly) NSTimeInterval applyDuration;
+
+/**
+ *  Time from the refresh being scheduled until it was applied to the map view.
+ */
+@property (nonatomic, readonly) NSTimeInterval totalDuration;
+
+/**
+ *  The zoom level of the map view when the refresh was scheduled.
+ */
+@property (nonatomic, readonly) ABFZoomLevel zoomLevel;
+
+/**
+ *  YES if the refresh performed a clustering fetch.
+ */
+@property (nonatomic, readonly) BOOL clustered;
+
+/**
+ *  YES if the annotations were split from the objects of the previous fetch instead of fetching from Realm.
+ */
+@property (nonatomic, readonly) BOOL split;
+
+/**
+ *  YES if the fetch was aggregate-only because of the memory budget or memory pressure.
+ *
+ *  @see ABFLocationFetchedResultsController memoryBudget
+ */
+@property (nonatomic, readonly) BOOL aggregateOnly;
+
+/**
+ *  The number of Realm objects fetched.
+ */
+@property (nonatomic, readonly) NSUInteger objectCount;
+
+/**
+ *  The number of annotations produced by the fetch.
+ */
+@property (nonatomic, readonly) NSUInteger annotationCount;
+
+/**
+ *  The number of ABFAnnotation instances allocated by the fetch.
+ */
+@property (nonatomic, readonly) NSUInteger allocatedAnnotationCount;
+
+/**
+ *  The number of recycled ABFAnnotation instances reused by the fetch.
+ */
+@property (nonatomic, readonly) NSUInteger reusedAnnotationCount;
+
+/**
+ *  The number of safeObjects arrays and objectCountsByLayer dictionaries allocated for the annotations by the fetch.
+ */
+@property (nonatomic, readonly) NSUInteger allocatedContainerCount;
+
+/**
+ *  The number of annotations added to the map view.
+ */
+@property (nonatomic, readonly) NSUInteger addedCount;
+
+/**
+ *  The number of annotations removed from the map view.
+ */
+@property (nonatomic, readonly) NSUInteger removedCount;
+
+/**
+ *  The estimated memory usage of the fetched results controller after the fetch.
+ */
+@property (nonatomic, readonly) NSUInteger memoryUsage;
+
+@end
+
+/**
+ *  Block called on the main thread after each refresh has been applied to the map view.
+ */
+typedef void(^ABFRefreshMetricsHandler)(ABFRefreshMetrics * _Nonnull metrics);
+
+/**
+ *  The refresh pipeline shared by ABFRealmMapView and RealmMapView.
+ *
+ *  Each refresh builds a location fetch request for the visible region, then on a serial background queue fetches (and clusters) the objects with the fetched results controller, diffs the resulting annotations against those currently displayed (recycling the new annotations that are already displayed), and applies the changes to the map view on the main thread. Scheduling a new refresh cancels any refresh that has not started yet.
+ *
+ *  When the zoom level passes maxZoomLevelForClustering (or the map zooms in while not clustering) and the visible region is contained by the previous fetch, the clusters are split into unique annotations for their members rather than fetched again. Annotations for single objects are equal before and after the split, so only the clusters are replaced on the map view.
+ *
+ *  When the fetched results controller's memoryBudget would be exceeded, or the system reports memory pressure, refreshes cluster aggregate-only, even above maxZoomLevelForClustering. Memory pressure also releases the controller's caches and refreshes the map view.
+ *
+ *  The pipeline also observes Realm change notifications for the current fetch when autoRefresh is enabled, and manages the heat map overlay when heatMap is enabled.
+ */
+@interface ABFMapRefreshPipeline : NSObject
+
+/**
+ *  The map view the pipeline reads the visible region from and applies annotations to.
+ */
+@property (nonatomic, weak, readonly, nullable) MKMapView *mapView;
+
+/**
+ *  The controller that fetches the Realm objects
+ */
+@property (nonatomic, readonly, nonnull) ABFLocationFetchedResultsController *fetchResultsController;
+
+/**
+ *  The Realm in which the specified entity exists
+ */
+@property (nonatomic, readonly, nonnull) RLMRealm *realm;
+
+/**
+ *  The configuration for the Realm in which the entity resides
+ *
+ *  Default is [RLMRealmConfiguration defaultConfiguration]
+ */
+@property (nonatomic, strong, null_resettable) RLMRealmConfiguration *realmConfiguration;
+
+/**
+ *  The Realm object's name being fetched
+ */
+@property (nonatomic, strong, nullable) NSString *entityName;
+
+/**
+ *  The key path on fetched Realm objects for the latitude value
+ */
+@property (nonatomic, strong, nullable) NSString *latitudeKeyPath;
+
+/**
+ *  The key path on fetched Realm objects for the longitude value
+ */
+@property (nonatomic, strong, nullable) NSString *longitudeKeyPath;
+
+/**
+ *  The key path on fetched Realm objects for the title of the annotation view
+ */
+@property (nonatomic, strong, nullable) NSString *titleKeyPath;
+
+/**
+ *  The key path on fetched Realm objects for the subtitle of the annotation view
+ */
+@property (nonatomic, strong, nullable) NSString *subtitleKeyPath;
+
+/**
+ *  Predicate included, via AND, along with the generated predicate for the location bounding box.
+ */
+@property (nonatomic, strong, nullable) NSPredicate *basePredicate;
+
+/**
+ *  Layers to display instead of entityName, each with its own entity, key paths, predicate and color.
+ *
+ *  The layers are fetched concurrently and clustered together, and their changes are applied to the map view in one update. While layers is set, entityName, the key paths, basePredicate and heatMap are ignored.
+ *
+ *  Default is nil
+ */
+@property (nonatomic, copy, nullable) NSArray<ABFMapLayer *> *layers;
+
+/**
+ *  The sort descriptor of the fetched results controller, setting it makes the next refresh fetch instead of splitting the previous fetch.
+ *
+ *  Each refresh assigns it to the fetched results controller on the map queue, set it here rather than on the controller.
+ *
+ *  Default is nil
+ */
+@property (nonatomic, strong, nullable) ABFLocationSortDescriptor *sortDescriptor;
+
+/**
+ *  Designates if the refresh will cluster the annotations
+ *
+ *  Default is YES
+ */
+@property (nonatomic, assign) BOOL clusterAnnotations;
+
+/**
+ *  Designates if the pipeline refreshes when Realm change notifications are received
+ *
+ *  Default is YES
+ */
+@property (nonatomic, assign) BOOL autoRefresh;
+
+/**
+ *  Designates if the first refresh with results zooms the map view to a region that contains them
+ *
+ *  Default is YES
+ */
+@property (nonatomic, assign) BOOL zoomOnFirstRefresh;
+
+/**
+ *  Max zoom level of the map view to perform clustering on.
+ *
+ *  Default is 20
+ */
+@property (nonatomic, assign) ABFZoomLevel maxZoomLevelForClustering;
+
+/**
+ *  Number of zoom levels below maxZoomLevelForClustering the map view must zoom out to before clustering resumes.
+ *
+ *  Clustering stops as soon as the zoom level exceeds maxZoomLevelForClustering, so pinching back and forth across the threshold does not switch between clusters and unique annotations on every refresh. 0 switches exactly at the threshold.
+ *
+ *  Default is 1
+ */
+@property (nonatomic, assign) ABFZoomLevel clusteringZoomHysteresis;
+
+/**
+ *  Designates if a heat map overlay is displayed instead of annotations
+ *
+ *  Ignored while layers is set, the heat map is not supported with layers.
+ *
+ *  Default is NO
+ */
+@property (nonatomic, assign) BOOL heatMap;
+
+/**
+ *  The heat map overlay when heatMap is enabled, otherwise nil.
+ */
+@property (nonatomic, readonly, nullable) ABFHeatMapTileOverlay *heatMapOverlay;
+
+/**
+ *  The metrics for the most recently applied refresh, nil before the first refresh.
+ */
+@property (atomic, readonly, nullable) ABFRefreshMetrics *lastRefreshMetrics;
+
+/**
+ *  Optional block called with the metrics of each applied refresh
+ */
+@property (nonatomic, copy, nullable) ABFRefreshMetricsHandler metricsHandler;
+
+/**
+ *  If set, the viewport and fetch mode (heat map, split, clustered, aggregate-only, layers) of each refresh, Realm change notifications and the metrics of each applied refresh are recorded to the trace.
+ *
+ *  Default is nil (no recording)
+ *
+ *  @see ABFRefreshTraceReplayer
+ */
+@property (atomic, strong, nullable) ABFRefreshTrace *trace;
+
+/**
+ *  Creates a refresh pipeline for a map view.
+ *
+ *  @param mapView the map view to display the annotations (held weakly)
+ *
+ *  @return instance of ABFMapRefreshPipeline
+ */
+- (nonnull instancetype)initWithMapView:(nonnull MKMapView *)mapView;
+
+/**
+ *  Schedules a fresh fetch for Realm objects based on the current visible map rect
+ */
+- (void)refresh;
+
+/**
+ *  Stops observing Realm change notifications and cancels pending refreshes
+ */
+- (void)stop;
+
+/**
+ *  Calculates the region that contains the safe objects with some padding, adjusted to fit the map view
+ *
+ *  @param safeObjects array of ABFLocationSafeRealmObject
+ *
+ *  @return region for the map view to display the safe objects
+ */
+- (MKCoordinateRegion)coordinateRegionForSafeObjects:(nonnull NSArray<ABFLocationSafeRealmObject *> *)safeObjects;
+
+/**
+ *  The layer an annotation is displayed for: the layer of a unique annotation, or the layer with the most objects in a cluster
+ *
+ *  @param annotation annotation from the fetched results controller
+ *
+ *  @return layer of the annotation, nil if layers is not set
+ */
+- (nullable ABFMapLayer *)layerForAnnotation:(nonnull ABFAnnotation *)annotation;
+
+@end
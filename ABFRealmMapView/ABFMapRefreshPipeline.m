@@ -0,0 +1,979 @@
+//
+//  ABFMapRefreshPipeline.m
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#import "ABFMapRefreshPipeline.h"
+#import "ABFLocationFetchRequest.h"
+
+#pragma mark - ABFRefreshMetrics
+
+@interface ABFRefreshMetrics ()
+
+@property (nonatomic, assign) CFAbsoluteTime scheduledTime;
+
+@property (nonatomic, readwrite) NSTimeInterval fetchDuration;
+
+@property (nonatomic, readwrite) NSTimeInterval diffDuration;
+
+@property (nonatomic, readwrite) NSTimeInterval applyDuration;
+
+@property (nonatomic, readwrite) NSTimeInterval totalDuration;
+
+@property (nonatomic, readwrite) ABFZoomLevel zoomLevel;
+
+@property (nonatomic, readwrite) BOOL clustered;
+
+@property (nonatomic, readwrite) BOOL split;
+
+@property (nonatomic, readwrite) BOOL aggregateOnly;
+
+@property (nonatomic, readwrite) NSUInteger objectCount;
+
+@property (nonatomic, readwrite) NSUInteger annotationCount;
+
+@property (nonatomic, readwrite) NSUInteger allocatedAnnotationCount;
+
+@property (nonatomic, readwrite) NSUInteger reusedAnnotationCount;
+
+@property (nonatomic, readwrite) NSUInteger allocatedContainerCount;
+
+@property (nonatomic, readwrite) NSUInteger addedCount;
+
+@property (nonatomic, readwrite) NSUInteger removedCount;
+
+@property (nonatomic, readwrite) NSUInteger memoryUsage;
+
+@end
+
+@implementation ABFRefreshMetrics
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> zoom %lu%@%@%@, %lu objects, %lu annotations (%lu allocated, %lu reused, %lu containers, +%lu/-%lu), %.1fKB, fetch %.1fms, diff %.1fms, apply %.1fms, total %.1fms",
+            NSStringFromClass([self class]),
+            self,
+            (unsigned long)self.zoomLevel,
+            self.clustered ? @" clustered" : @"",
+            self.split ? @" split" : @"",
+            self.aggregateOnly ? @" aggregate-only" : @"",
+            (unsigned long)self.objectCount,
+            (unsigned long)self.annotationCount,
+            (unsigned long)self.allocatedAnnotationCount,
+            (unsigned long)self.reusedAnnotationCount,
+            (unsigned long)self.allocatedContainerCount,
+            (unsigned long)self.addedCount,
+            (unsigned long)self.removedCount,
+            self.memoryUsage / 1024.0,
+            self.fetchDuration * 1000,
+            self.diffDuration * 1000,
+            self.applyDuration * 1000,
+            self.totalDuration * 1000];
+}
+
+@end
+
+#pragma mark - ABFMapRefreshPipeline
+
+@interface ABFMapRefreshPipeline ()
+
+@property (nonatomic, strong) NSOperationQueue *mapQueue;
+
+/**
+ *  One notification token for each fetch request (one per layer)
+ */
+@property (nonatomic, strong) NSArray<RLMNotificationToken *> *notificationTokens;
+
+@property (nonatomic, strong) NSArray<id<RLMCollection>> *notificationCollections;
+
+@property (nonatomic, strong) NSRunLoop *notificationRunLoop;
+
+@property (nonatomic, strong) ABFHeatMapTileOverlay *heatMapOverlay;
+
+@property (atomic, strong) ABFRefreshMetrics *lastRefreshMetrics;
+
+/**
+ *  Whether the last scheduled refresh clustered, used to apply clusteringZoomHysteresis. Reset to YES when the configuration changes or clustering is turned back on.
+ */
+@property (nonatomic, assign) BOOL clusteringActive;
+
+/**
+ *  Set when the objects of the previous fetch can no longer be split (configuration or Realm changed)
+ */
+@property (atomic, assign) BOOL needsFetch;
+
+/**
+ *  The visible map rect the fetched results controller's objects cover.
+ *
+ *  Only accessed from the map queue.
+ */
+@property (nonatomic, assign) MKMapRect lastFetchMapRect;
+
+/**
+ *  The sort descriptor the fetched results controller's objects are sorted by.
+ *
+ *  Only accessed from the map queue.
+ */
+@property (nonatomic, strong) ABFLocationSortDescriptor *lastFetchSortDescriptor;
+
+@property (nonatomic, strong) dispatch_source_t memoryPressureSource;
+
+/**
+ *  The annotations the pipeline has applied to the map view.
+ *
+ *  Only accessed from the map queue, so that the diff never reads the map view off the main thread.
+ */
+@property (nonatomic, strong) NSSet *displayedAnnotations;
+
+@end
+
+@implementation ABFMapRefreshPipeline
+@synthesize realmConfiguration = _realmConfiguration;
+@synthesize sortDescriptor = _sortDescriptor;
+
+#pragma mark - Init
+
+- (instancetype)initWithMapView:(MKMapView *)mapView
+{
+    self = [super init];
+    
+    if (self) {
+        _mapView = mapView;
+        
+        _fetchResultsController = [[ABFLocationFetchedResultsController alloc] init];
+        
+        _clusterAnnotations = YES;
+        _autoRefresh = YES;
+        _zoomOnFirstRefresh = YES;
+        _maxZoomLevelForClustering = 20;
+        _clusteringZoomHysteresis = 1;
+        _clusteringActive = YES;
+        _needsFetch = YES;
+        _lastFetchMapRect = MKMapRectNull;
+        
+        _displayedAnnotations = [NSSet set];
+        
+        _mapQueue = [[NSOperationQueue alloc] init];
+        _mapQueue.maxConcurrentOperationCount = 1;
+        
+        [self observeMemoryPressure];
+    }
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [self registerChangeNotification:NO];
+    
+    if (_memoryPressureSource) {
+        dispatch_source_cancel(_memoryPressureSource);
+    }
+}
+
+#pragma mark - Setters
+
+- (void)setRealmConfiguration:(RLMRealmConfiguration *)realmConfiguration
+{
+    @synchronized(self) {
+        _realmConfiguration = realmConfiguration;
+        _needsFetch = YES;
+        _clusteringActive = YES;
+    }
+}
+
+- (void)setEntityName:(NSString *)entityName
+{
+    @synchronized(self) {
+        _entityName = entityName;
+        _needsFetch = YES;
+        _clusteringActive = YES;
+    }
+}
+
+- (void)setLatitudeKeyPath:(NSString *)latitudeKeyPath
+{
+    @synchronized(self) {
+        _latitudeKeyPath = latitudeKeyPath;
+        _needsFetch = YES;
+        _clusteringActive = YES;
+    }
+}
+
+- (void)setLongitudeKeyPath:(NSString *)longitudeKeyPath
+{
+    @synchronized(self) {
+        _longitudeKeyPath = longitudeKeyPath;
+        _needsFetch = YES;
+        _clusteringActive = YES;
+    }
+}
+
+- (void)setTitleKeyPath:(NSString *)titleKeyPath
+{
+    @synchronized(self) {
+        _titleKeyPath = titleKeyPath;
+        _needsFetch = YES;
+    }
+}
+
+- (void)setSubtitleKeyPath:(NSString *)subtitleKeyPath
+{
+    @synchronized(self) {
+        _subtitleKeyPath = subtitleKeyPath;
+        _needsFetch = YES;
+    }
+}
+
+- (void)setBasePredicate:(NSPredicate *)basePredicate
+{
+    @synchronized(self) {
+        _basePredicate = basePredicate;
+        _needsFetch = YES;
+        _clusteringActive = YES;
+    }
+}
+
+- (void)setLayers:(NSArray<ABFMapLayer *> *)layers
+{
+    @synchronized(self) {
+        _layers = layers.copy;
+        _needsFetch = YES;
+        _clusteringActive = YES;
+        
+        if (layers.count) {
+            [self removeHeatMapOverlay];
+        }
+    }
+}
+
+- (void)setSortDescriptor:(ABFLocationSortDescriptor *)sortDescriptor
+{
+    @synchronized(self) {
+        _sortDescriptor = sortDescriptor;
+        _needsFetch = YES;
+    }
+}
+
+- (void)setClusterAnnotations:(BOOL)clusterAnnotations
+{
+    @synchronized(self) {
+        // Hysteresis only applies after zooming in past the threshold, not to clustering turned back on
+        if (clusterAnnotations && !_clusterAnnotations) {
+            _clusteringActive = YES;
+        }
+        
+        _clusterAnnotations = clusterAnnotations;
+    }
+}
+
+- (void)setMaxZoomLevelForClustering:(ABFZoomLevel)maxZoomLevelForClustering
+{
+    @synchronized(self) {
+        _maxZoomLevelForClustering = maxZoomLevelForClustering;
+        _clusteringActive = YES;
+    }
+}
+
+- (void)setHeatMap:(BOOL)heatMap
+{
+    @synchronized(self) {
+        _heatMap = heatMap;
+        _needsFetch = YES;
+        
+        if (!heatMap) {
+            [self removeHeatMapOverlay];
+        }
+    }
+}
+
+#pragma mark - Getters
+
+- (ABFLocationSortDescriptor *)sortDescriptor
+{
+    @synchronized(self) {
+        return _sortDescriptor;
+    }
+}
+
+- (RLMRealm *)realm
+{
+    return [RLMRealm realmWithConfiguration:self.realmConfiguration error:nil];
+}
+
+- (RLMRealmConfiguration *)realmConfiguration
+{
+    if (_realmConfiguration) {
+        return _realmConfiguration;
+    }
+    
+    return [RLMRealmConfiguration defaultConfiguration];
+}
+
+#pragma mark - Public Instance
+
+- (void)refresh
+{
+    MKMapView *mapView = self.mapView;
+    
+    NSArray<ABFMapLayer *> *layers = self.layers;
+    
+    BOOL layered = layers.count > 0;
+    
+    if (!mapView ||
+        (!layered &&
+         (!self.entityName ||
+          !self.latitudeKeyPath ||
+          !self.longitudeKeyPath))) {
+        return;
+    }
+    
+    @synchronized(self) {
+        [self.mapQueue cancelAllOperations];
+        
+        ABFRefreshMetrics *metrics = [[ABFRefreshMetrics alloc] init];
+        metrics.scheduledTime = CFAbsoluteTimeGetCurrent();
+        
+        MKCoordinateRegion currentRegion = mapView.region;
+        
+        if (layered) {
+            NSMutableArray *fetchRequests = [NSMutableArray arrayWithCapacity:layers.count];
+            
+            for (ABFMapLayer *layer in layers) {
+                [fetchRequests addObject:[self fetchRequestWithEntityName:layer.entityName
+                                                          latitudeKeyPath:layer.latitudeKeyPath
+                                                         longitudeKeyPath:layer.longitudeKeyPath
+                                                            basePredicate:layer.basePredicate
+                                                                forRegion:currentRegion]];
+            }
+            
+            [self.fetchResultsController updateLayers:layers
+                                        fetchRequests:fetchRequests];
+        }
+        else {
+            ABFLocationFetchRequest *fetchRequest = [self fetchRequestWithEntityName:self.entityName
+                                                                     latitudeKeyPath:self.latitudeKeyPath
+                                                                    longitudeKeyPath:self.longitudeKeyPath
+                                                                       basePredicate:self.basePredicate
+                                                                           forRegion:currentRegion];
+            
+            [self.fetchResultsController updateLocationFetchRequest:fetchRequest
+                                                       titleKeyPath:self.titleKeyPath
+                                                    subtitleKeyPath:self.subtitleKeyPath];
+        }
+        
+        typeof(self) __weak weakSelf = self;
+        
+        NSBlockOperation *refreshOperation = [[NSBlockOperation alloc] init];
+        
+        NSBlockOperation __weak *weakOp = refreshOperation;
+        
+        MKMapRect visibleMapRect = mapView.visibleMapRect;
+        
+        ABFZoomLevel currentZoomLevel = ABFZoomLevelForVisibleMapRect(visibleMapRect);
+        
+        metrics.zoomLevel = currentZoomLevel;
+        
+        MKZoomScale zoomScale = MKZoomScaleForMapView(mapView);
+        
+        if (self.heatMap &&
+            !layered) {
+            
+            [self.trace recordViewportWithRegion:currentRegion
+                                  visibleMapRect:visibleMapRect
+                                       zoomScale:zoomScale
+                                            mode:ABFRefreshTraceModeHeatMap
+                                    memoryBudget:self.fetchResultsController.memoryBudget
+                                layerIdentifiers:nil];
+            
+            [self updateHeatMapOverlay];
+            
+            [refreshOperation addExecutionBlock:^{
+                if (![weakOp isCancelled]) {
+                    // Every heat map refresh clears the annotations, a cancelled one leaves it to the next refresh
+                    [weakSelf removeDisplayedAnnotations];
+                    
+                    [weakSelf registerChangeNotification:weakSelf.autoRefresh];
+                }
+            }];
+        }
+        else {
+            BOOL clustered = [self shouldClusterAtZoomLevel:currentZoomLevel];
+            
+            metrics.clustered = clustered;
+            
+            NSArray<NSString *> *layerIdentifiers = layered ? [layers valueForKey:@"identifier"] : nil;
+            
+            ABFLocationSortDescriptor *sortDescriptor = _sortDescriptor;
+            
+            ABFRefreshTrace *trace = self.trace;
+            
+            // Reserved now so Realm changes recorded during the fetch are replayed after it
+            NSUInteger viewportEventIndex = NSNotFound;
+            
+            if (trace) {
+                viewportEventIndex = [trace reserveViewportWithRegion:currentRegion
+                                                       visibleMapRect:visibleMapRect
+                                                            zoomScale:zoomScale
+                                                     layerIdentifiers:layerIdentifiers];
+            }
+            
+            [refreshOperation addExecutionBlock:^{
+                if (![weakOp isCancelled]) {
+                    // Assigned on the map queue, where the controller reads it for every object
+                    weakSelf.fetchResultsController.sortDescriptor = sortDescriptor;
+                    
+                    CFAbsoluteTime fetchStart = CFAbsoluteTimeGetCurrent();
+                    
+                    BOOL split = (!clustered &&
+                                  [weakSelf canSplitPreviousFetchForVisibleMapRect:visibleMapRect] &&
+                                  [weakSelf.fetchResultsController performSplitFetchForRegion:currentRegion]);
+                    
+                    metrics.split = split;
+                    
+                    if (!split) {
+                        // Changes after this point require another fetch
+                        weakSelf.needsFetch = NO;
+                        
+                        // Too many objects for unique annotations, degrade to aggregate-only clusters
+                        BOOL clusteredFetch = (clustered ||
+                                               [weakSelf.fetchResultsController fetchRequestExceedsMemoryBudget]);
+                        
+                        metrics.clustered = clusteredFetch;
+                        
+                        if (clusteredFetch) {
+                            [weakSelf.fetchResultsController performClusteringFetchForVisibleMapRect:visibleMapRect
+                                                                                           zoomScale:zoomScale];
+                        }
+                        else {
+                            [weakSelf.fetchResultsController performFetch];
+                        }
+                        
+                        weakSelf.lastFetchSortDescriptor = weakSelf.fetchResultsController.sortDescriptor;
+                    }
+                    
+                    weakSelf.lastFetchMapRect = visibleMapRect;
+                    
+                    metrics.fetchDuration = CFAbsoluteTimeGetCurrent() - fetchStart;
+                    metrics.allocatedAnnotationCount = weakSelf.fetchResultsController.allocatedAnnotationCount;
+                    metrics.reusedAnnotationCount = weakSelf.fetchResultsController.reusedAnnotationCount;
+                    metrics.allocatedContainerCount = weakSelf.fetchResultsController.allocatedContainerCount;
+                    metrics.aggregateOnly = weakSelf.fetchResultsController.aggregateOnly;
+                    metrics.memoryUsage = weakSelf.fetchResultsController.memoryUsage;
+                    
+                    // Completed once the path is decided so a replay takes the same one
+                    [weakSelf completeViewportAtIndex:viewportEventIndex
+                                              inTrace:trace
+                                              metrics:metrics];
+                    
+                    [weakSelf applyAnnotations:weakSelf.fetchResultsController.annotations
+                                   safeObjects:weakSelf.fetchResultsController.safeObjects
+                                       metrics:metrics];
+                    
+                    [weakSelf registerChangeNotification:weakSelf.autoRefresh];
+                }
+            }];
+        }
+        
+        [self.mapQueue addOperation:refreshOperation];
+    }
+}
+
+- (void)stop
+{
+    [self.mapQueue cancelAllOperations];
+    
+    [self registerChangeNotification:NO];
+}
+
+- (MKCoordinateRegion)coordinateRegionForSafeObjects:(NSArray *)safeObjects
+{
+    MKMapRect rect = MKMapRectNull;
+    
+    for (ABFLocationSafeRealmObject *safeObject in safeObjects) {
+        MKMapPoint point = MKMapPointForCoordinate(safeObject.coordinate);
+        
+        rect = MKMapRectUnion(rect, MKMapRectMake(point.x, point.y, 0, 0));
+    }
+    
+    return [self coordinateRegionThatFitsMapRect:rect];
+}
+
+- (ABFMapLayer *)layerForAnnotation:(ABFAnnotation *)annotation
+{
+    NSArray<ABFMapLayer *> *layers = self.layers;
+    
+    __block NSString *layerIdentifier = annotation.layerIdentifier;
+    
+    if (!layerIdentifier) {
+        // Clusters take the layer with the most objects
+        __block NSUInteger maxCount = 0;
+        
+        [annotation.objectCountsByLayer enumerateKeysAndObjectsUsingBlock:^(NSString *identifier,
+                                                                            NSNumber *count,
+                                                                            BOOL *stop) {
+            if (count.unsignedIntegerValue > maxCount) {
+                maxCount = count.unsignedIntegerValue;
+                layerIdentifier = identifier;
+            }
+        }];
+    }
+    
+    for (ABFMapLayer *layer in layers) {
+        if ([layer.identifier isEqualToString:layerIdentifier]) {
+            return layer;
+        }
+    }
+    
+    return nil;
+}
+
+#pragma mark - Private Instance
+
+/**
+ *  Region for the annotations of an aggregate-only fetch, whose safe objects are only the objects of single object cells
+ */
+- (MKCoordinateRegion)coordinateRegionForAnnotations:(NSSet<ABFAnnotation *> *)annotations
+{
+    MKMapRect rect = MKMapRectNull;
+    
+    for (ABFAnnotation *annotation in annotations) {
+        MKMapPoint point = MKMapPointForCoordinate(annotation.coordinate);
+        
+        rect = MKMapRectUnion(rect, MKMapRectMake(point.x, point.y, 0, 0));
+    }
+    
+    return [self coordinateRegionThatFitsMapRect:rect];
+}
+
+- (MKCoordinateRegion)coordinateRegionThatFitsMapRect:(MKMapRect)rect
+{
+    MKCoordinateRegion region = MKCoordinateRegionForMapRect(rect);
+    
+    MKMapView *mapView = self.mapView;
+    
+    if (mapView) {
+        region = [mapView regionThatFits:region];
+    }
+    
+    region.span.latitudeDelta *= 1.3;
+    region.span.longitudeDelta *= 1.3;
+    
+    return region;
+}
+
+- (ABFLocationFetchRequest *)fetchRequestWithEntityName:(NSString *)entityName
+                                        latitudeKeyPath:(NSString *)latitudeKeyPath
+                                       longitudeKeyPath:(NSString *)longitudeKeyPath
+                                          basePredicate:(NSPredicate *)basePredicate
+                                              forRegion:(MKCoordinateRegion)region
+{
+    ABFLocationFetchRequest *fetchRequest =
+    [ABFLocationFetchRequest locationFetchRequestWithEntityName:entityName
+                                                        inRealm:self.realm
+                                                latitudeKeyPath:latitudeKeyPath
+                                               longitudeKeyPath:longitudeKeyPath
+                                                      forRegion:region];
+    
+    if (basePredicate) {
+        NSCompoundPredicate *compPred =
+        [NSCompoundPredicate andPredicateWithSubpredicates:@[fetchRequest.predicate,basePredicate]];
+        
+        fetchRequest.predicate = compPred;
+    }
+    
+    return fetchRequest;
+}
+
+- (BOOL)shouldClusterAtZoomLevel:(ABFZoomLevel)zoomLevel
+{
+    if (!self.clusterAnnotations) {
+        self.clusteringActive = NO;
+    }
+    else if (self.clusteringActive) {
+        // Stop clustering as soon as the threshold is passed
+        self.clusteringActive = zoomLevel <= self.maxZoomLevelForClustering;
+    }
+    else {
+        // Resume clustering only below the hysteresis band
+        ABFZoomLevel hysteresis = MIN(self.clusteringZoomHysteresis, self.maxZoomLevelForClustering);
+        
+        self.clusteringActive = zoomLevel + hysteresis <= self.maxZoomLevelForClustering;
+    }
+    
+    return self.clusteringActive;
+}
+
+/**
+ *  Called on the map queue
+ */
+- (void)completeViewportAtIndex:(NSUInteger)index
+                        inTrace:(ABFRefreshTrace *)trace
+                        metrics:(ABFRefreshMetrics *)metrics
+{
+    if (!trace) {
+        return;
+    }
+    
+    ABFRefreshTraceMode mode = 0;
+    
+    if (metrics.clustered) {
+        mode |= ABFRefreshTraceModeClustered;
+    }
+    
+    if (metrics.split) {
+        mode |= ABFRefreshTraceModeSplit;
+    }
+    
+    if (metrics.aggregateOnly) {
+        mode |= ABFRefreshTraceModeAggregateOnly;
+    }
+    
+    if (self.fetchResultsController.underMemoryPressure) {
+        mode |= ABFRefreshTraceModeUnderMemoryPressure;
+    }
+    
+    [trace completeViewportAtIndex:index
+                              mode:mode
+                      memoryBudget:self.fetchResultsController.memoryBudget];
+}
+
+/**
+ *  Called on the map queue. A truncated (results limited) fetch could be missing objects of the new region.
+ */
+- (BOOL)canSplitPreviousFetchForVisibleMapRect:(MKMapRect)visibleMapRect
+{
+    return (!self.needsFetch &&
+            !self.fetchResultsController.aggregateOnly &&
+            self.fetchResultsController.resultsLimit < 0 &&
+            self.fetchResultsController.sortDescriptor == self.lastFetchSortDescriptor &&
+            !MKMapRectIsNull(self.lastFetchMapRect) &&
+            MKMapRectContainsRect(self.lastFetchMapRect, visibleMapRect));
+}
+
+/**
+ *  Diff stage runs on the map queue, apply stage on the main thread
+ */
+- (void)applyAnnotations:(NSSet *)annotations
+             safeObjects:(NSArray *)safeObjects
+                 metrics:(ABFRefreshMetrics *)metrics
+{
+    typeof(self) __weak weakSelf = self;
+    
+    BOOL aggregateOnly = metrics.aggregateOnly;
+    
+    NSUInteger objectCount = safeObjects.count;
+    
+    // Aggregate-only clusters have no safe objects for their members
+    if (aggregateOnly) {
+        objectCount = 0;
+        
+        for (ABFAnnotation *annotation in annotations) {
+            objectCount += annotation.objectCount;
+        }
+    }
+    
+    metrics.objectCount = objectCount;
+    metrics.annotationCount = annotations.count;
+    
+    // Trigger zoom on first run if necessary
+    if (self.zoomOnFirstRefresh &&
+        objectCount > 0) {
+        self.zoomOnFirstRefresh = NO;
+        
+        [[NSOperationQueue mainQueue] addOperationWithBlock:^() {
+            MKCoordinateRegion region = (aggregateOnly ?
+                                         [weakSelf coordinateRegionForAnnotations:annotations] :
+                                         [weakSelf coordinateRegionForSafeObjects:safeObjects]);
+            
+            [weakSelf.mapView setRegion:region animated:YES];
+        }];
+        
+        return;
+    }
+    
+    CFAbsoluteTime diffStart = CFAbsoluteTimeGetCurrent();
+    
+    NSSet *currentAnnotations = self.displayedAnnotations;
+    
+    NSSet *newAnnotations = annotations;
+    
+    // Find current annotations we are keeping
+    NSMutableSet *toKeep = [NSMutableSet setWithSet:currentAnnotations];
+    
+    [toKeep intersectSet:newAnnotations];
+    
+    // Find the new annotations we need to add form toKeep
+    NSMutableSet *toAdd = [NSMutableSet setWithSet:newAnnotations];
+    
+    [toAdd minusSet:toKeep];
+    
+    // Find the current annotations to remove from the new ones
+    NSMutableSet *toRemove = [NSMutableSet setWithSet:currentAnnotations];
+    
+    [toRemove minusSet:newAnnotations];
+    
+    // Kept annotations stay the instances already on the map
+    [toKeep unionSet:toAdd];
+    
+    self.displayedAnnotations = toKeep.copy;
+    
+    // The new instances equal to ones already displayed are never shown, reuse them next fetch
+    [self.fetchResultsController replaceAnnotations:newAnnotations
+                           withDisplayedAnnotations:self.displayedAnnotations];
+    
+    metrics.diffDuration = CFAbsoluteTimeGetCurrent() - diffStart;
+    metrics.addedCount = toAdd.count;
+    metrics.removedCount = toRemove.count;
+    
+    // Trigger display on map view
+    [[NSOperationQueue mainQueue] addOperationWithBlock:^() {
+        CFAbsoluteTime applyStart = CFAbsoluteTimeGetCurrent();
+        
+        [weakSelf.mapView addAnnotations:[toAdd allObjects]];
+        [weakSelf.mapView removeAnnotations:[toRemove allObjects]];
+        
+        CFAbsoluteTime applyEnd = CFAbsoluteTimeGetCurrent();
+        
+        metrics.applyDuration = applyEnd - applyStart;
+        metrics.totalDuration = applyEnd - metrics.scheduledTime;
+        
+        weakSelf.lastRefreshMetrics = metrics;
+        
+        [weakSelf.trace recordRefreshWithMetrics:metrics];
+        
+        ABFRefreshMetricsHandler metricsHandler = weakSelf.metricsHandler;
+        
+        if (metricsHandler) {
+            metricsHandler(metrics);
+        }
+    }];
+}
+
+- (void)updateHeatMapOverlay
+{
+    ABFHeatMapTileOverlay *heatMapOverlay = self.heatMapOverlay;
+    
+    if (!heatMapOverlay ||
+        ![heatMapOverlay.entityName isEqualToString:self.entityName] ||
+        ![heatMapOverlay.latitudeKeyPath isEqualToString:self.latitudeKeyPath] ||
+        ![heatMapOverlay.longitudeKeyPath isEqualToString:self.longitudeKeyPath]) {
+        
+        ABFHeatMapTileOverlay *oldOverlay = heatMapOverlay;
+        
+        heatMapOverlay = [[ABFHeatMapTileOverlay alloc] initWithEntityName:self.entityName
+                                                                   inRealm:self.realm
+                                                           latitudeKeyPath:self.latitudeKeyPath
+                                                          longitudeKeyPath:self.longitudeKeyPath];
+        
+        self.heatMapOverlay = heatMapOverlay;
+        
+        typeof(self) __weak weakSelf = self;
+        
+        // On the main queue so the next refresh can't cancel the swap, the refresh operation removes the annotations
+        [[NSOperationQueue mainQueue] addOperationWithBlock:^() {
+            if (oldOverlay) {
+                [weakSelf.mapView removeOverlay:oldOverlay];
+            }
+            
+            [weakSelf.mapView addOverlay:heatMapOverlay level:MKOverlayLevelAboveRoads];
+        }];
+    }
+    
+    if (heatMapOverlay.basePredicate != self.basePredicate &&
+        ![heatMapOverlay.basePredicate isEqual:self.basePredicate]) {
+        
+        heatMapOverlay.basePredicate = self.basePredicate;
+        
+        [self reloadHeatMapOverlay];
+    }
+}
+
+/**
+ *  Called on the map queue. Annotations are replaced by the heat map overlay.
+ */
+- (void)removeDisplayedAnnotations
+{
+    NSSet *displayedAnnotations = self.displayedAnnotations;
+    
+    if (displayedAnnotations.count == 0) {
+        return;
+    }
+    
+    self.displayedAnnotations = [NSSet set];
+    
+    typeof(self) __weak weakSelf = self;
+    
+    [[NSOperationQueue mainQueue] addOperationWithBlock:^() {
+        [weakSelf.mapView removeAnnotations:displayedAnnotations.allObjects];
+    }];
+}
+
+- (void)removeHeatMapOverlay
+{
+    ABFHeatMapTileOverlay *heatMapOverlay = self.heatMapOverlay;
+    
+    if (heatMapOverlay) {
+        self.heatMapOverlay = nil;
+        
+        typeof(self) __weak weakSelf = self;
+        
+        [[NSOperationQueue mainQueue] addOperationWithBlock:^() {
+            [weakSelf.mapView removeOverlay:heatMapOverlay];
+        }];
+    }
+}
+
+- (void)reloadHeatMapOverlay
+{
+    ABFHeatMapTileOverlay *heatMapOverlay = self.heatMapOverlay;
+    
+    [heatMapOverlay reloadTiles];
+    
+    typeof(self) __weak weakSelf = self;
+    
+    [[NSOperationQueue mainQueue] addOperationWithBlock:^() {
+        MKOverlayRenderer *renderer = [weakSelf.mapView rendererForOverlay:heatMapOverlay];
+        
+        if ([renderer isKindOfClass:[MKTileOverlayRenderer class]]) {
+            [(MKTileOverlayRenderer *)renderer reloadData];
+        }
+    }];
+}
+
+- (void)observeMemoryPressure
+{
+    self.memoryPressureSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE,
+                                                       0,
+                                                       DISPATCH_MEMORYPRESSURE_NORMAL | DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+                                                       dispatch_get_main_queue());
+    
+    if (!self.memoryPressureSource) {
+        return;
+    }
+    
+    typeof(self) __weak weakSelf = self;
+    
+    dispatch_source_set_event_handler(self.memoryPressureSource, ^{
+        dispatch_source_t source = weakSelf.memoryPressureSource;
+        
+        if (source) {
+            BOOL underMemoryPressure = (dispatch_source_get_data(source) & (DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL)) != 0;
+            
+            [weakSelf handleMemoryPressure:underMemoryPressure];
+        }
+    });
+    
+    dispatch_resume(self.memoryPressureSource);
+}
+
+/**
+ *  Called on the main thread. Fetches are aggregate-only while under pressure, and unique annotations come back with the refresh once it ends.
+ */
+- (void)handleMemoryPressure:(BOOL)underMemoryPressure
+{
+    if (self.fetchResultsController.underMemoryPressure == underMemoryPressure) {
+        return;
+    }
+    
+    self.fetchResultsController.underMemoryPressure = underMemoryPressure;
+    
+    // The objects of the previous fetch can't be split into aggregate-only clusters, or back
+    self.needsFetch = YES;
+    
+    if (!self.heatMap ||
+        self.layers.count) {
+        [self refresh];
+    }
+    
+    if (underMemoryPressure) {
+        typeof(self) __weak weakSelf = self;
+        
+        // Queued after the refresh so it isn't cancelled by it, a later refresh releases the caches itself under pressure
+        [self.mapQueue addOperationWithBlock:^{
+            [weakSelf.fetchResultsController reduceMemoryUsage];
+        }];
+    }
+}
+
+- (void)registerChangeNotification:(BOOL)registerNotifications
+{
+    if (registerNotifications) {
+        typeof(self) __weak weakSelf = self;
+        
+        // Setup run loop
+        if (!self.notificationRunLoop) {
+            dispatch_semaphore_t sem = dispatch_semaphore_create(0);
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+                CFRunLoopPerformBlock(CFRunLoopGetCurrent(), kCFRunLoopDefaultMode, ^{
+                    weakSelf.notificationRunLoop = [NSRunLoop currentRunLoop];
+                    
+                    dispatch_semaphore_signal(sem);
+                });
+                
+                CFRunLoopRun();
+            });
+            
+            dispatch_semaphore_wait(sem, DISPATCH_TIME_FOREVER);
+        }
+        
+        CFRunLoopPerformBlock(self.notificationRunLoop.getCFRunLoop, kCFRunLoopDefaultMode, ^{
+            for (RLMNotificationToken *notificationToken in weakSelf.notificationTokens) {
+                [notificationToken invalidate];
+            }
+            
+            weakSelf.notificationTokens = nil;
+            weakSelf.notificationCollections = nil;
+            
+            ABFLocationFetchedResultsController *fetchResultsController = weakSelf.fetchResultsController;
+            
+            NSArray *fetchRequests = fetchResultsController.layerFetchRequests ?
+            fetchResultsController.layerFetchRequests : @[fetchResultsController.fetchRequest];
+            
+            NSMutableArray *notificationTokens = [NSMutableArray arrayWithCapacity:fetchRequests.count];
+            NSMutableArray *notificationCollections = [NSMutableArray arrayWithCapacity:fetchRequests.count];
+            
+            [fetchRequests enumerateObjectsUsingBlock:^(ABFLocationFetchRequest *fetchRequest,
+                                                        NSUInteger layerIndex,
+                                                        BOOL *stop) {
+                id<RLMCollection> notificationCollection = fetchRequest.fetchObjects;
+                
+                RLMNotificationToken *notificationToken =
+                [notificationCollection addNotificationBlock:^(id<RLMCollection>  _Nullable collection,
+                                                               RLMCollectionChange * _Nullable change,
+                                                               NSError * _Nullable error) {
+                    if (!error &&
+                        change) {
+                        [weakSelf.trace recordRealmChange:change layerIndex:layerIndex];
+                        
+                        weakSelf.needsFetch = YES;
+                        
+                        if (weakSelf.heatMap &&
+                            !weakSelf.layers.count) {
+                            [weakSelf reloadHeatMapOverlay];
+                        }
+                        
+                        [weakSelf refresh];
+                    }
+                }];
+                
+                [notificationCollections addObject:notificationCollection];
+                [notificationTokens addObject:notificationToken];
+            }];
+            
+            weakSelf.notificationCollections = notificationCollections.copy;
+            weakSelf.notificationTokens = notificationTokens.copy;
+        });
+        
+        CFRunLoopWakeUp(self.notificationRunLoop.getCFRunLoop);
+    }
+    else if (self.notificationRunLoop) {
+        CFRunLoopStop(self.notificationRunLoop.getCFRunLoop);
+        self.notificationRunLoop = nil;
+    }
+}
+
+@end
@@ -16,7 +16,13 @@ FOUNDATION_EXPORT const unsigned char ABFRealmMapViewVersionString[];
 
 #import <ABFRealmMapView/ABFRealmMapView.h>
 #import <ABFRealmMapView/ABFLocationFetchRequest.h>
+#import <ABFRealmMapView/ABFLocationShapeFetchRequest.h>
+#import <ABFRealmMapView/ABFGeometry.h>
 #import <ABFRealmMapView/ABFLocationFetchedResultsController.h>
 #import <ABFRealmMapView/ABFClusterAnnotationView.h>
+#import <ABFRealmMapView/ABFHeatMapTileOverlay.h>
+#import <ABFRealmMapView/ABFMapRefreshPipeline.h>
+#import <ABFRealmMapView/ABFRefreshTrace.h>
+#import <ABFRealmMapView/ABFMapLayer.h>
 
 
@@ -6,6 +6,8 @@
 //
 
 #import "ABFLocationFetchedResultsController.h"
+#import "ABFHeatMapTileOverlay.h"
+#import "ABFMapRefreshPipeline.h"
 
 @import MapKit;
 
@@ -48,6 +50,15 @@
  */
 @property (nonatomic, readonly, nonnull) ABFLocationFetchedResultsController *fetchResultsController;
 
+/**
+ *  The pipeline that performs the refreshes for the map view
+ *
+ *  Use to observe the refresh metrics.
+ *
+ *  @see ABFMapRefreshPipeline
+ */
+@property (nonatomic, readonly, nonnull) ABFMapRefreshPipeline *refreshPipeline;
+
 /**
  *  The Realm object's name being fetched for the map view
  */
@@ -112,6 +123,26 @@
  */
 @property (nonatomic, assign) IBInspectable BOOL canShowCallout;
 
+/**
+ *  Designates if the map view will display a heat map of the object density instead of annotations
+ *
+ *  Use for large data sets where individual annotations become the bottleneck. The tiles are rendered off the main thread by heatMapOverlay.
+ *
+ *  The heat map is not supported with layers: while layers is set, annotations are displayed and heatMap is ignored.
+ *
+ *  Default is NO
+ */
+@property (nonatomic, assign) IBInspectable BOOL heatMap;
+
+/**
+ *  The overlay that renders the heat map tiles when heatMap is enabled, otherwise nil.
+ *
+ *  Use to customize the radius and gradient of the heat map.
+ *
+ *  @see ABFHeatMapTileOverlay
+ */
+@property (nonatomic, readonly, nullable) ABFHeatMapTileOverlay *heatMapOverlay;
+
 /**
  *  Max zoom level of the map view to perform clustering on.
  *
@@ -123,6 +154,15 @@
  */
 @property (nonatomic, assign) ABFZoomLevel maxZoomLevelForClustering;
 
+/**
+ *  Number of zoom levels below maxZoomLevelForClustering the map must zoom out to before clustering resumes.
+ *
+ *  Prevents switching between clusters and unique annotations while pinching around the threshold.
+ *
+ *  Default is 1
+ */
+@property (nonatomic, assign) ABFZoomLevel clusteringZoomHysteresis;
+
 /**
  *  The limit on how many results from Realm will be added to the map.
  *
@@ -132,12 +172,44 @@
  */
 @property (nonatomic, assign) ABFResultsLimit resultsLimit;
 
+/**
+ *  Approximate number of bytes the fetched results controller may hold for the map.
+ *
+ *  When a fetch would exceed the budget, the map shows aggregate-only clusters (clusters without their safe objects).
+ *
+ *  Default is 0, or no budget.
+ */
+@property (nonatomic, assign) NSUInteger memoryBudget;
+
+/**
+ *  Estimate of the bytes currently held by the fetched results controller.
+ */
+@property (nonatomic, readonly) NSUInteger memoryUsage;
+
 /**
  *  Use this property to filter items found by the map. This predicate will be included, via AND,
  *  along with the generated predicate for the location bounding box.
  */
 @property (nonatomic, strong, nullable) NSPredicate *basePredicate;
 
+/**
+ *  Sorts the objects by distance, which decides the objects kept when resultsLimit is set.
+ *
+ *  Default is nil
+ *
+ *  @see ABFLocationSortDescriptor
+ */
+@property (nonatomic, strong, nullable) ABFLocationSortDescriptor *sortDescriptor;
+
+/**
+ *  Layers to display instead of entityName, each with its own entity, key paths, predicate and color.
+ *
+ *  The layers are fetched concurrently and clustered together. Annotation views use the color of the annotation's layer (for clusters, the layer with the most objects), views of layers without a color keep their own. While layers is set, heatMap is ignored.
+ *
+ *  Default is nil
+ */
+@property (nonatomic, copy, nullable) NSArray<ABFMapLayer *> *layers;
+
 /**
  *  Creates a map view that automatically handles fetching Realm objects and displaying annotations
  *
@@ -13,26 +13,35 @@
 #pragma mark - Constants
 
 static NSString * const ABFAnnotationViewReuseId = @"ABFAnnotationViewReuseId";
+static NSString * const ABFLayerAnnotationViewReuseId = @"ABFLayerAnnotationViewReuseId";
 
 #pragma mark - ABFRealmMapView
 
 @interface ABFRealmMapView () <MKMapViewDelegate>
 
-@property (nonatomic, strong) NSOperationQueue *mapQueue;
-
 @property (nonatomic, weak) id<MKMapViewDelegate>externalDelegate;
 
-@property (nonatomic, strong) RLMNotificationToken *notificationToken;
-
-@property (nonatomic, strong) id<RLMCollection> notificationCollection;
-
-@property (nonatomic, strong) NSRunLoop *notificationRunLoop;
-
 @end
 
 @implementation ABFRealmMapView
-@synthesize realmConfiguration = _realmConfiguration;
-@dynamic resultsLimit;
+@dynamic realmConfiguration,
+entityName,
+latitudeKeyPath,
+longitudeKeyPath,
+titleKeyPath,
+subtitleKeyPath,
+clusterAnnotations,
+autoRefresh,
+zoomOnFirstRefresh,
+maxZoomLevelForClustering,
+clusteringZoomHysteresis,
+resultsLimit,
+memoryBudget,
+memoryUsage,
+basePredicate,
+sortDescriptor,
+layers,
+heatMap;
 
 #pragma mark - Init
 
@@ -46,15 +55,12 @@ static NSString * const ABFAnnotationViewReuseId = @"ABFAnnotationViewReuseId";
     self = [self init];
     
     if (self) {
-        _entityName = entityName;
-        _realmConfiguration = realm.configuration;
-        _latitudeKeyPath = latitudeKeyPath;
-        _longitudeKeyPath = longitudeKeyPath;
-        _titleKeyPath = titleKeyPath;
-        _subtitleKeyPath = subtitleKeyPath;
-        
-        _mapQueue = [[NSOperationQueue alloc] init];
-        _mapQueue.maxConcurrentOperationCount = 1;
+        _refreshPipeline.entityName = entityName;
+        _refreshPipeline.realmConfiguration = realm.configuration;
+        _refreshPipeline.latitudeKeyPath = latitudeKeyPath;
+        _refreshPipeline.longitudeKeyPath = longitudeKeyPath;
+        _refreshPipeline.titleKeyPath = titleKeyPath;
+        _refreshPipeline.subtitleKeyPath = subtitleKeyPath;
     }
     
     return self;
@@ -98,22 +104,17 @@ static NSString * const ABFAnnotationViewReuseId = @"ABFAnnotationViewReuseId";
     // Set the main delegate (we will proxy if user sets delegate)
     [super setDelegate:self];
     
-    _fetchResultsController = [[ABFLocationFetchedResultsController alloc] init];
+    if (!_refreshPipeline) {
+        _refreshPipeline = [[ABFMapRefreshPipeline alloc] initWithMapView:self];
+    }
     
-    _clusterAnnotations = YES;
-    _autoRefresh = YES;
-    _zoomOnFirstRefresh = YES;
-    _maxZoomLevelForClustering = 20;
     _animateAnnotations = YES;
     _canShowCallout = YES;
-    
-    _mapQueue = [[NSOperationQueue alloc] init];
-    _mapQueue.maxConcurrentOperationCount = 1;
 }
 
 - (void)dealloc
 {
-    [self registerChangeNotification:NO];
+    [_refreshPipeline stop];
 }
 
 #pragma mark - <MKMapViewDelegate>
@@ -197,15 +198,24 @@ static NSString * const ABFAnnotationViewReuseId = @"ABFAnnotationViewReuseId";
         
         ABFAnnotation *fetchedAnnotation = (ABFAnnotation *)annotation;
         
-        ABFClusterAnnotationView *annotationView = (ABFClusterAnnotationView *)[mapView dequeueReusableAnnotationViewWithIdentifier:ABFAnnotationViewReuseId];
+        UIColor *layerColor = [self.refreshPipeline layerForAnnotation:fetchedAnnotation].color;
+        
+        // Views colored by a layer are reused separately, so the other views keep their own color
+        NSString *reuseIdentifier = layerColor ? ABFLayerAnnotationViewReuseId : ABFAnnotationViewReuseId;
+        
+        ABFClusterAnnotationView *annotationView = (ABFClusterAnnotationView *)[mapView dequeueReusableAnnotationViewWithIdentifier:reuseIdentifier];
         
         if (!annotationView) {
             annotationView = [[ABFClusterAnnotationView alloc] initWithAnnotation:fetchedAnnotation
-                                                                  reuseIdentifier:ABFAnnotationViewReuseId];
+                                                                  reuseIdentifier:reuseIdentifier];
             annotationView.canShowCallout = self.canShowCallout;
         }
         
-        annotationView.count = fetchedAnnotation.safeObjects.count;
+        if (layerColor) {
+            annotationView.color = layerColor;
+        }
+        
+        annotationView.count = fetchedAnnotation.objectCount;
         annotationView.annotation = fetchedAnnotation;
         
         return annotationView;
@@ -322,6 +332,9 @@ static NSString * const ABFAnnotationViewReuseId = @"ABFAnnotationViewReuseId";
     if ([delegate respondsToSelector:@selector(mapView:rendererForOverlay:)]) {
         return [delegate mapView:mapView rendererForOverlay:overlay];
     }
+    else if ([overlay isKindOfClass:[ABFHeatMapTileOverlay class]]) {
+        return [[MKTileOverlayRenderer alloc] initWithTileOverlay:(ABFHeatMapTileOverlay *)overlay];
+    }
     
     return nil;
 }
@@ -374,44 +387,57 @@ static NSString * const ABFAnnotationViewReuseId = @"ABFAnnotationViewReuseId";
 
 - (void)setRealmConfiguration:(RLMRealmConfiguration *)realmConfiguration
 {
-    @synchronized(self) {
-        _realmConfiguration = realmConfiguration;
-    }
+    self.refreshPipeline.realmConfiguration = realmConfiguration;
 }
 
 - (void)setEntityName:(NSString *)entityName
 {
-    @synchronized(self) {
-        _entityName = entityName;
-    }
+    self.refreshPipeline.entityName = entityName;
 }
 
 - (void)setLatitudeKeyPath:(NSString *)latitudeKeyPath
 {
-    @synchronized(self) {
-        _latitudeKeyPath = latitudeKeyPath;
-    }
+    self.refreshPipeline.latitudeKeyPath = latitudeKeyPath;
 }
 
 - (void)setLongitudeKeyPath:(NSString *)longitudeKeyPath
 {
-    @synchronized(self) {
-        _longitudeKeyPath = longitudeKeyPath;
-    }
+    self.refreshPipeline.longitudeKeyPath = longitudeKeyPath;
 }
 
 - (void)setTitleKeyPath:(NSString *)titleKeyPath
 {
-    @synchronized(self) {
-        _titleKeyPath = titleKeyPath;
-    }
+    self.refreshPipeline.titleKeyPath = titleKeyPath;
 }
 
 - (void)setSubtitleKeyPath:(NSString *)subtitleKeyPath
 {
-    @synchronized(self) {
-        _subtitleKeyPath = subtitleKeyPath;
-    }
+    self.refreshPipeline.subtitleKeyPath = subtitleKeyPath;
+}
+
+- (void)setClusterAnnotations:(BOOL)clusterAnnotations
+{
+    self.refreshPipeline.clusterAnnotations = clusterAnnotations;
+}
+
+- (void)setAutoRefresh:(BOOL)autoRefresh
+{
+    self.refreshPipeline.autoRefresh = autoRefresh;
+}
+
+- (void)setZoomOnFirstRefresh:(BOOL)zoomOnFirstRefresh
+{
+    self.refreshPipeline.zoomOnFirstRefresh = zoomOnFirstRefresh;
+}
+
+- (void)setMaxZoomLevelForClustering:(ABFZoomLevel)maxZoomLevelForClustering
+{
+    self.refreshPipeline.maxZoomLevelForClustering = maxZoomLevelForClustering;
+}
+
+- (void)setClusteringZoomHysteresis:(ABFZoomLevel)clusteringZoomHysteresis
+{
+    self.refreshPipeline.clusteringZoomHysteresis = clusteringZoomHysteresis;
 }
 
 - (void)setResultsLimit:(ABFResultsLimit)resultsLimit
@@ -419,24 +445,96 @@ static NSString * const ABFAnnotationViewReuseId = @"ABFAnnotationViewReuseId";
     self.fetchResultsController.resultsLimit = resultsLimit;
 }
 
+- (void)setMemoryBudget:(NSUInteger)memoryBudget
+{
+    self.fetchResultsController.memoryBudget = memoryBudget;
+}
+
+- (void)setBasePredicate:(NSPredicate *)basePredicate
+{
+    self.refreshPipeline.basePredicate = basePredicate;
+}
+
+- (void)setSortDescriptor:(ABFLocationSortDescriptor *)sortDescriptor
+{
+    self.refreshPipeline.sortDescriptor = sortDescriptor;
+}
+
+- (void)setLayers:(NSArray<ABFMapLayer *> *)layers
+{
+    self.refreshPipeline.layers = layers;
+}
+
+- (void)setHeatMap:(BOOL)heatMap
+{
+    self.refreshPipeline.heatMap = heatMap;
+}
+
 #pragma mark - Getters
 
 - (RLMRealm *)realm
 {
-    if (self.realmConfiguration) {
-        return [RLMRealm realmWithConfiguration:self.realmConfiguration error:nil];
-    }
-    
-    return [RLMRealm defaultRealm];
+    return self.refreshPipeline.realm;
 }
 
 - (RLMRealmConfiguration *)realmConfiguration
 {
-    if (_realmConfiguration) {
-        return _realmConfiguration;
-    }
-    
-    return [RLMRealmConfiguration defaultConfiguration];
+    return self.refreshPipeline.realmConfiguration;
+}
+
+- (ABFLocationFetchedResultsController *)fetchResultsController
+{
+    return self.refreshPipeline.fetchResultsController;
+}
+
+- (NSString *)entityName
+{
+    return self.refreshPipeline.entityName;
+}
+
+- (NSString *)latitudeKeyPath
+{
+    return self.refreshPipeline.latitudeKeyPath;
+}
+
+- (NSString *)longitudeKeyPath
+{
+    return self.refreshPipeline.longitudeKeyPath;
+}
+
+- (NSString *)titleKeyPath
+{
+    return self.refreshPipeline.titleKeyPath;
+}
+
+- (NSString *)subtitleKeyPath
+{
+    return self.refreshPipeline.subtitleKeyPath;
+}
+
+- (BOOL)clusterAnnotations
+{
+    return self.refreshPipeline.clusterAnnotations;
+}
+
+- (BOOL)autoRefresh
+{
+    return self.refreshPipeline.autoRefresh;
+}
+
+- (BOOL)zoomOnFirstRefresh
+{
+    return self.refreshPipeline.zoomOnFirstRefresh;
+}
+
+- (ABFZoomLevel)maxZoomLevelForClustering
+{
+    return self.refreshPipeline.maxZoomLevelForClustering;
+}
+
+- (ABFZoomLevel)clusteringZoomHysteresis
+{
+    return self.refreshPipeline.clusteringZoomHysteresis;
 }
 
 - (ABFResultsLimit)resultsLimit
@@ -444,136 +542,50 @@ static NSString * const ABFAnnotationViewReuseId = @"ABFAnnotationViewReuseId";
     return self.fetchResultsController.resultsLimit;
 }
 
-#pragma mark - Public Instance
+- (NSUInteger)memoryBudget
+{
+    return self.fetchResultsController.memoryBudget;
+}
 
-- (void)refreshMapView
+- (NSUInteger)memoryUsage
 {
-    @synchronized(self) {
-        [self.mapQueue cancelAllOperations];
-        
-        MKCoordinateRegion currentRegion = self.region;
-        
-        ABFLocationFetchRequest *fetchRequest =
-        [ABFLocationFetchRequest locationFetchRequestWithEntityName:self.entityName
-                                                            inRealm:self.realm
-                                                    latitudeKeyPath:self.latitudeKeyPath
-                                                   longitudeKeyPath:self.longitudeKeyPath
-                                                          forRegion:currentRegion];
-        
-        if (self.basePredicate) {
-            NSCompoundPredicate *compPred =
-            [NSCompoundPredicate andPredicateWithSubpredicates:@[fetchRequest.predicate,self.basePredicate]];
-            
-            fetchRequest.predicate = compPred;
-        }
-        
-        [self.fetchResultsController updateLocationFetchRequest:fetchRequest
-                                                   titleKeyPath:self.titleKeyPath
-                                                subtitleKeyPath:self.subtitleKeyPath];
-        
-        typeof(self) __weak weakSelf = self;
-        
-        NSBlockOperation *refreshOperation = [[NSBlockOperation alloc] init];
-        
-        NSBlockOperation __weak *weakOp = refreshOperation;
-        
-        MKMapRect visibleMapRect = self.visibleMapRect;
-        
-        ABFZoomLevel currentZoomLevel = ABFZoomLevelForVisibleMapRect(visibleMapRect);
-        
-        if (self.clusterAnnotations &&
-            currentZoomLevel <= self.maxZoomLevelForClustering) {
-            
-            MKZoomScale zoomScale = MKZoomScaleForMapView(self);
-            
-            [refreshOperation addExecutionBlock:^{
-                if (![weakOp isCancelled]) {
-                    [weakSelf.fetchResultsController performClusteringFetchForVisibleMapRect:visibleMapRect
-                                                                                   zoomScale:zoomScale];
-                    
-                    [weakSelf addAnnotationsToMapView:weakSelf.fetchResultsController.annotations];
-                    
-                    [weakSelf registerChangeNotification:weakSelf.autoRefresh];
-                }
-            }];
-        }
-        else {
-            [refreshOperation addExecutionBlock:^{
-                if (![weakOp isCancelled]) {
-                    [weakSelf.fetchResultsController performFetch];
-                    
-                    [weakSelf addAnnotationsToMapView:weakSelf.fetchResultsController.annotations];
-                    
-                    [weakSelf registerChangeNotification:weakSelf.autoRefresh];
-                }
-            }];
-        }
-        
-        [self.mapQueue addOperation:refreshOperation];
-    }
+    return self.fetchResultsController.memoryUsage;
 }
 
-#pragma mark - Private Instance
+- (NSPredicate *)basePredicate
+{
+    return self.refreshPipeline.basePredicate;
+}
 
-- (void)addAnnotationsToMapView:(NSSet *)annotations
+- (ABFLocationSortDescriptor *)sortDescriptor
 {
-    typeof(self) __weak weakSelf = self;
-    
-    NSMutableSet *currentAnnotations = nil;
-    
-    /**
-     *  Must wrap calls to self.annotations in try block
-     *
-     *  Internally the map view creates the array on demand and will
-     *  throw an exception for a nil object occasionally!
-     */
-    @try {
-        if (self.annotations) {
-            currentAnnotations = [NSMutableSet setWithArray:self.annotations];
-        }
-    }
-    @catch (NSException *exception) {
-        // Ignoring exceptions thrown!
-    }
-        
-    NSSet *newAnnotations = annotations;
-    
-    // Find current annotations we are keeping
-    NSMutableSet *toKeep = [NSMutableSet setWithSet:currentAnnotations];
-    
-    [toKeep intersectSet:newAnnotations];
-    
-    // Find the new annotations we need to add form toKeep
-    NSMutableSet *toAdd = [NSMutableSet setWithSet:newAnnotations];
-    
-    [toAdd minusSet:toKeep];
-    
-    // Find the current annotations to remove from the new ones
-    NSMutableSet *toRemove = [NSMutableSet setWithSet:currentAnnotations];
-    
-    [toRemove minusSet:newAnnotations];
-    
-    NSArray *safeObjects = self.fetchResultsController.safeObjects;
-    
-    // Trigger display on map view
-    [[NSOperationQueue mainQueue] addOperationWithBlock:^() {
-        
-        // Trigger zoom on first run if necessary
-        if (weakSelf.zoomOnFirstRefresh &&
-            safeObjects.count > 0) {
-            weakSelf.zoomOnFirstRefresh = NO;
-            
-            MKCoordinateRegion region = [weakSelf coordinateRegionForSafeObjects:safeObjects];
-            
-            [weakSelf setRegion:region animated:YES];
-        }
-        else {
-            [weakSelf addAnnotations:[toAdd allObjects]];
-            [weakSelf removeAnnotations:[toRemove allObjects]];
-        }
-    }];
+    return self.refreshPipeline.sortDescriptor;
+}
+
+- (NSArray<ABFMapLayer *> *)layers
+{
+    return self.refreshPipeline.layers;
+}
+
+- (BOOL)heatMap
+{
+    return self.refreshPipeline.heatMap;
 }
 
+- (ABFHeatMapTileOverlay *)heatMapOverlay
+{
+    return self.refreshPipeline.heatMapOverlay;
+}
+
+#pragma mark - Public Instance
+
+- (void)refreshMapView
+{
+    [self.refreshPipeline refresh];
+}
+
+#pragma mark - Private Instance
+
 - (void)addAnimationToView:(UIView *)view
 {
     view.transform = CGAffineTransformScale(CGAffineTransformIdentity, 0.05, 0.05);
@@ -589,72 +601,4 @@ static NSString * const ABFAnnotationViewReuseId = @"ABFAnnotationViewReuseId";
                      completion:nil];
 }
 
-- (MKCoordinateRegion)coordinateRegionForSafeObjects:(NSArray *)safeObjects
-{
-    MKMapRect rect = MKMapRectNull;
-    
-    for (ABFLocationSafeRealmObject *safeObject in safeObjects) {
-        MKMapPoint point = MKMapPointForCoordinate(safeObject.coordinate);
-        
-        rect = MKMapRectUnion(rect, MKMapRectMake(point.x, point.y, 0, 0));
-    }
-    
-    MKCoordinateRegion region = MKCoordinateRegionForMapRect(rect);
-    
-    region = [self regionThatFits:region];
-    
-    region.span.latitudeDelta *= 1.3;
-    region.span.longitudeDelta *= 1.3;
-    
-    return region;
-}
-
-- (void)registerChangeNotification:(BOOL)registerNotifications
-{    
-    if (registerNotifications) {
-        typeof(self) __weak weakSelf = self;
-        
-        // Setup run loop
-        if (!self.notificationRunLoop) {
-            dispatch_semaphore_t sem = dispatch_semaphore_create(0);
-            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
-                CFRunLoopPerformBlock(CFRunLoopGetCurrent(), kCFRunLoopDefaultMode, ^{
-                    weakSelf.notificationRunLoop = [NSRunLoop currentRunLoop];
-                    
-                    dispatch_semaphore_signal(sem);
-                });
-                
-                CFRunLoopRun();
-            });
-            
-            dispatch_semaphore_wait(sem, DISPATCH_TIME_FOREVER);
-        }
-        
-        CFRunLoopPerformBlock(self.notificationRunLoop.getCFRunLoop, kCFRunLoopDefaultMode, ^{
-            if (weakSelf.notificationToken) {
-                [weakSelf.notificationToken invalidate];
-                weakSelf.notificationToken = nil;
-                weakSelf.notificationCollection = nil;
-            }
-            
-            weakSelf.notificationCollection = weakSelf.fetchResultsController.fetchRequest.fetchObjects;
-            weakSelf.notificationToken = [weakSelf.notificationCollection
-                                          addNotificationBlock:^(id<RLMCollection>  _Nullable collection,
-                                                                 RLMCollectionChange * _Nullable change,
-                                                                 NSError * _Nullable error) {
-                                              if (!error &&
-                                                  change) {
-                                                  [weakSelf refreshMapView];
-                                              }
-                                          }];
-        });
-        
-        CFRunLoopWakeUp(self.notificationRunLoop.getCFRunLoop);
-    }
-    else if (self.notificationRunLoop) {
-        CFRunLoopStop(self.notificationRunLoop.getCFRunLoop);
-        self.notificationRunLoop = nil;
-    }
-}
-
 @end
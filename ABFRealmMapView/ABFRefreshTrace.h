@@ -0,0 +1,452 @@
+//
+//  ABFRefreshTrace.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#import "ABFLocationFetchedResultsController.h"
+
+@import MapKit;
+
+#if __has_include(<RealmMapView/RealmMapView.h>)
+@import Realm;
+#else
+#import <Realm/Realm.h>
+#endif
+
+@class ABFRefreshMetrics;
+@class ABFMapLayer;
+@class ABFHeatMapTileOverlay;
+
+/**
+ *  Defines the types of ABFRefreshTraceEvent
+ */
+typedef NS_ENUM(uint8_t, ABFRefreshTraceEventType){
+    /**
+     *  A refresh was scheduled for the viewport in the event
+     */
+    ABFRefreshTraceEventTypeViewport,
+    /**
+     *  A Realm change notification was received for the current fetch
+     */
+    ABFRefreshTraceEventTypeRealmChange,
+    /**
+     *  A refresh was applied to the map view, with its timings
+     */
+    ABFRefreshTraceEventTypeRefresh,
+};
+
+/**
+ *  How a refresh fetched its annotations, recorded so a replay takes the same path
+ */
+typedef NS_OPTIONS(uint8_t, ABFRefreshTraceMode){
+    /**
+     *  A clustering fetch, either for the zoom level or because the objects exceeded the memory budget
+     */
+    ABFRefreshTraceModeClustered = 1 << 0,
+    /**
+     *  The heat map overlay was displayed instead of annotations
+     */
+    ABFRefreshTraceModeHeatMap = 1 << 1,
+    /**
+     *  The clusters of the previous fetch were split without fetching
+     */
+    ABFRefreshTraceModeSplit = 1 << 2,
+    /**
+     *  The clustering fetch was aggregate-only
+     */
+    ABFRefreshTraceModeAggregateOnly = 1 << 3,
+    /**
+     *  The system reported memory pressure
+     */
+    ABFRefreshTraceModeUnderMemoryPressure = 1 << 4,
+    /**
+     *  The refresh was cancelled by a later one before it fetched, replays skip it
+     */
+    ABFRefreshTraceModeCancelled = 1 << 5,
+};
+
+/**
+ *  A single fixed-size record in an ABFRefreshTrace
+ */
+typedef struct {
+    /**
+     *  The type of event, which defines which member of the union is valid
+     */
+    ABFRefreshTraceEventType type;
+    /**
+     *  How the refresh fetched, for viewport and refresh events
+     */
+    ABFRefreshTraceMode mode;
+    /**
+     *  The set of layers that were fetched, 0 if the refresh was not layered
+     *
+     *  @see ABFRefreshTrace layerIdentifiersForEvent:
+     */
+    uint16_t layerSet;
+    /**
+     *  The zoom level of the map view
+     */
+    uint32_t zoomLevel;
+    /**
+     *  Seconds since the trace was created
+     */
+    NSTimeInterval timestamp;
+    union {
+        struct {
+            MKCoordinateRegion region;
+            MKMapRect visibleMapRect;
+            double zoomScale;
+            uint64_t memoryBudget;
+        } viewport;
+        struct {
+            uint32_t insertionCount;
+            uint32_t deletionCount;
+            uint32_t modificationCount;
+            uint32_t layerIndex;
+        } realmChange;
+        struct {
+            NSTimeInterval fetchDuration;
+            NSTimeInterval diffDuration;
+            NSTimeInterval applyDuration;
+            NSTimeInterval totalDuration;
+            uint32_t objectCount;
+            uint32_t annotationCount;
+        } refresh;
+    };
+} ABFRefreshTraceEvent;
+
+/**
+ *  Compact recording of the viewports, Realm change events and refresh timings of a map view.
+ *
+ *  Assign an instance to ABFMapRefreshPipeline trace to record, then save it with writeToURL:error:
+ *  and replay it against a dataset snapshot with ABFRefreshTraceReplayer.
+ *
+ *  Events are stored as fixed-size binary records; recording is thread-safe.
+ */
+@interface ABFRefreshTrace : NSObject
+
+/**
+ *  The number of events recorded
+ */
+@property (nonatomic, readonly) NSUInteger eventCount;
+
+/**
+ *  Recording stops once this many events have been recorded.
+ *
+ *  Default is 100000
+ */
+@property (nonatomic, assign) NSUInteger maximumEventCount;
+
+/**
+ *  Creates an instance of ABFRefreshTrace from data created by dataRepresentation.
+ *
+ *  @param data  the trace data
+ *  @param error if the data is not a valid trace, upon return contains an error
+ *
+ *  @return instance of ABFRefreshTrace or nil if the data is invalid
+ */
++ (nullable instancetype)traceWithData:(nonnull NSData *)data
+                                 error:(NSError * _Nullable * _Nullable)error;
+
+/**
+ *  Creates an instance of ABFRefreshTrace from a file written with writeToURL:error:
+ *
+ *  @param url   the file URL of the trace
+ *  @param error upon return contains an error if reading failed
+ *
+ *  @return instance of ABFRefreshTrace or nil if reading failed
+ */
++ (nullable instancetype)traceWithContentsOfURL:(nonnull NSURL *)url
+                                          error:(NSError * _Nullable * _Nullable)error;
+
+/**
+ *  Binary representation of the trace
+ */
+- (nonnull NSData *)dataRepresentation;
+
+/**
+ *  Writes the binary representation of the trace to a file
+ *
+ *  @param url   the file URL to write to
+ *  @param error upon return contains an error if writing failed
+ *
+ *  @return YES if the trace was written
+ */
+- (BOOL)writeToURL:(nonnull NSURL *)url
+             error:(NSError * _Nullable * _Nullable)error;
+
+/**
+ *  Records the viewport of a refresh and how it fetched
+ *
+ *  @param region           the region of the map view
+ *  @param visibleMapRect   the visible map rect of the map view
+ *  @param zoomScale        the zoom scale of the map view
+ *  @param mode             how the refresh fetched (or displayed the heat map)
+ *  @param memoryBudget     the memory budget of the fetched results controller
+ *  @param layerIdentifiers the identifiers of the layers fetched, nil if the refresh was not layered
+ */
+- (void)recordViewportWithRegion:(MKCoordinateRegion)region
+                  visibleMapRect:(MKMapRect)visibleMapRect
+                       zoomScale:(MKZoomScale)zoomScale
+                            mode:(ABFRefreshTraceMode)mode
+                    memoryBudget:(NSUInteger)memoryBudget
+                layerIdentifiers:(nullable NSArray<NSString *> *)layerIdentifiers;
+
+/**
+ *  Records the viewport of a refresh when it is scheduled, before it decides how to fetch.
+ *
+ *  Realm changes recorded while the refresh fetches come after the event, so a replay applies them after the fetch too. The event is marked ABFRefreshTraceModeCancelled until completeViewportAtIndex:mode:memoryBudget: is called.
+ *
+ *  @param region           the region of the map view
+ *  @param visibleMapRect   the visible map rect of the map view
+ *  @param zoomScale        the zoom scale of the map view
+ *  @param layerIdentifiers the identifiers of the layers fetched, nil if the refresh is not layered
+ *
+ *  @return the index of the event, NSNotFound if the trace is full
+ */
+- (NSUInteger)reserveViewportWithRegion:(MKCoordinateRegion)region
+                         visibleMapRect:(MKMapRect)visibleMapRect
+                              zoomScale:(MKZoomScale)zoomScale
+                       layerIdentifiers:(nullable NSArray<NSString *> *)layerIdentifiers;
+
+/**
+ *  Records how a refresh reserved with reserveViewportWithRegion:visibleMapRect:zoomScale:layerIdentifiers: fetched
+ *
+ *  @param index        the index of the reserved event, NSNotFound is ignored
+ *  @param mode         how the refresh fetched
+ *  @param memoryBudget the memory budget of the fetched results controller
+ */
+- (void)completeViewportAtIndex:(NSUInteger)index
+                           mode:(ABFRefreshTraceMode)mode
+                   memoryBudget:(NSUInteger)memoryBudget;
+
+/**
+ *  Records that a Realm change notification triggered a refresh
+ *
+ *  @param change     the change to the fetched objects
+ *  @param layerIndex the index of the layer whose objects changed, 0 if the refresh is not layered
+ */
+- (void)recordRealmChange:(nonnull RLMCollectionChange *)change
+               layerIndex:(NSUInteger)layerIndex;
+
+/**
+ *  The identifiers of the layers fetched by a layered viewport or refresh event
+ *
+ *  @param event an event of the trace
+ *
+ *  @return the layer identifiers in the order they were fetched, nil if the event is not layered
+ */
+- (nullable NSArray<NSString *> *)layerIdentifiersForEvent:(ABFRefreshTraceEvent)event;
+
+/**
+ *  Records the timings of an applied refresh
+ *
+ *  @param metrics the metrics of the refresh
+ */
+- (void)recordRefreshWithMetrics:(nonnull ABFRefreshMetrics *)metrics;
+
+/**
+ *  Enumerates the events in the order they were recorded
+ *
+ *  @param block block called for each event; set stop to YES to end the enumeration
+ */
+- (void)enumerateEventsUsingBlock:(nonnull void (^)(ABFRefreshTraceEvent event, BOOL * _Nonnull stop))block;
+
+@end
+
+/**
+ *  A set of latency samples with percentile statistics.
+ *
+ *  Distributions can be saved with writeToURL:error: so that replays from two builds can be compared.
+ */
+@interface ABFLatencyDistribution : NSObject
+
+/**
+ *  The samples in seconds, sorted ascending
+ */
+@property (nonatomic, readonly, nonnull) NSArray<NSNumber *> *samples;
+
+/**
+ *  The mean sample, 0 if there are no samples
+ */
+@property (nonatomic, readonly) NSTimeInterval mean;
+
+/**
+ *  The median sample
+ */
+@property (nonatomic, readonly) NSTimeInterval p50;
+
+/**
+ *  The 95th percentile sample
+ */
+@property (nonatomic, readonly) NSTimeInterval p95;
+
+/**
+ *  The 99th percentile sample
+ */
+@property (nonatomic, readonly) NSTimeInterval p99;
+
+/**
+ *  The largest sample
+ */
+@property (nonatomic, readonly) NSTimeInterval max;
+
+/**
+ *  Creates an instance of ABFLatencyDistribution
+ *
+ *  @param samples latency samples in seconds (any order)
+ *
+ *  @return instance of ABFLatencyDistribution
+ */
++ (nonnull instancetype)distributionWithSamples:(nonnull NSArray<NSNumber *> *)samples;
+
+/**
+ *  Creates the distribution of the total refresh durations recorded in a trace
+ *
+ *  @param trace the recorded trace
+ *
+ *  @return instance of ABFLatencyDistribution
+ */
++ (nonnull instancetype)recordedDistributionForTrace:(nonnull ABFRefreshTrace *)trace;
+
+/**
+ *  Reads a distribution written with writeToURL:error:
+ *
+ *  @param url   the file URL of the distribution
+ *  @param error upon return contains an error if reading failed
+ *
+ *  @return instance of ABFLatencyDistribution or nil if reading failed
+ */
++ (nullable instancetype)distributionWithContentsOfURL:(nonnull NSURL *)url
+                                                 error:(NSError * _Nullable * _Nullable)error;
+
+/**
+ *  Writes the samples to a file
+ *
+ *  @param url   the file URL to write to
+ *  @param error upon return contains an error if writing failed
+ *
+ *  @return YES if the distribution was written
+ */
+- (BOOL)writeToURL:(nonnull NSURL *)url
+             error:(NSError * _Nullable * _Nullable)error;
+
+/**
+ *  Returns the sample at a percentile using the nearest-rank method
+ *
+ *  @param percentile value between 0 and 100
+ *
+ *  @return the sample in seconds, 0 if there are no samples
+ */
+- (NSTimeInterval)latencyAtPercentile:(double)percentile;
+
+/**
+ *  Checks whether the p95 latency regressed compared to a baseline
+ *
+ *  @param baseline  the distribution from the baseline build
+ *  @param tolerance allowed relative increase, for example 0.1 for 10%
+ *
+ *  @return YES if p95 is greater than the baseline p95 by more than the tolerance
+ */
+- (BOOL)isRegressionComparedToBaseline:(nonnull ABFLatencyDistribution *)baseline
+                             tolerance:(double)tolerance;
+
+/**
+ *  A human readable comparison of mean, p50, p95, p99 and max against a baseline
+ *
+ *  @param baseline the distribution from the baseline build
+ *
+ *  @return multi-line description
+ */
+- (nonnull NSString *)comparisonDescriptionWithBaseline:(nonnull ABFLatencyDistribution *)baseline;
+
+@end
+
+/**
+ *  Replays the viewports of a recorded trace through ABFLocationFetchedResultsController, without a map view.
+ *
+ *  Each viewport event takes the path the map view took (cancelled refreshes are skipped): a clustering or unique fetch, a split of the previous clusters, an aggregate-only fetch under the recorded memory budget and memory pressure, a fetch of the recorded layers, or the rendering of the visible heat map tiles. Realm change events apply writes of the recorded size to the objects of the current fetch, and the refreshes they triggered are recorded as viewports, so they are replayed in sequence.
+ *
+ *  Events are replayed back to back on the calling thread, so the result measures the fetch and clustering (or tile rendering) stages against the Realm, typically a snapshot of the dataset made with writeCopyToURL:encryptionKey:error:.
+ *
+ *  @warning Realm change events write to the Realm, replay against a copy of the snapshot.
+ */
+@interface ABFRefreshTraceReplayer : NSObject
+
+/**
+ *  The trace being replayed
+ */
+@property (nonatomic, readonly, nonnull) ABFRefreshTrace *trace;
+
+/**
+ *  The controller that performs the fetches, use to configure cluster sizes or results limit
+ */
+@property (nonatomic, readonly, nonnull) ABFLocationFetchedResultsController *fetchResultsController;
+
+/**
+ *  The key path on the Realm objects for the title of the annotations
+ */
+@property (nonatomic, strong, nullable) NSString *titleKeyPath;
+
+/**
+ *  The key path on the Realm objects for the subtitle of the annotations
+ */
+@property (nonatomic, strong, nullable) NSString *subtitleKeyPath;
+
+/**
+ *  Predicate included, via AND, along with the generated predicate for each viewport.
+ */
+@property (nonatomic, strong, nullable) NSPredicate *basePredicate;
+
+/**
+ *  The layers the map view displayed. Layered viewports fetch the layers with the recorded identifiers.
+ */
+@property (nonatomic, strong, nullable) NSArray<ABFMapLayer *> *layers;
+
+/**
+ *  Renders the tiles of heat map viewports, configure it like the heat map overlay of the map view. Nil if the Realm could not be opened.
+ */
+@property (nonatomic, readonly, nullable) ABFHeatMapTileOverlay *heatMapOverlay;
+
+/**
+ *  The content scale factor of the rendered heat map tiles.
+ *
+ *  Default is the scale of the main screen
+ */
+@property (nonatomic, assign) CGFloat contentScaleFactor;
+
+/**
+ *  Optional block that performs the writes of a Realm change event, inside a write transaction.
+ *
+ *  By default, the first objects of the current fetch are modified (the latitude is written again), copied (only for entities without a primary key) and deleted, as many as the recorded counts.
+ */
+@property (nonatomic, copy, nullable) void (^realmChangeBlock)(RLMRealm * _Nonnull realm, ABFLocationFetchRequest * _Nonnull fetchRequest, ABFRefreshTraceEvent event);
+
+/**
+ *  Creates a replayer for a trace
+ *
+ *  @param trace              the recorded trace
+ *  @param realmConfiguration the configuration of the Realm (snapshot) to fetch from
+ *  @param entityName         the Realm object name (class name)
+ *  @param latitudeKeyPath    the key path on the Realm objects for the latitude value
+ *  @param longitudeKeyPath   the key path on the Realm objects for the longitude value
+ *
+ *  @return instance of ABFRefreshTraceReplayer
+ */
+- (nonnull instancetype)initWithTrace:(nonnull ABFRefreshTrace *)trace
+                   realmConfiguration:(nonnull RLMRealmConfiguration *)realmConfiguration
+                           entityName:(nonnull NSString *)entityName
+                      latitudeKeyPath:(nonnull NSString *)latitudeKeyPath
+                     longitudeKeyPath:(nonnull NSString *)longitudeKeyPath;
+
+/**
+ *  Replays the trace synchronously on the calling thread
+ *
+ *  @return distribution of the fetch (or heat map rendering) latencies, one sample per replayed viewport
+ */
+- (nonnull ABFLatencyDistribution *)replay;
+
+@end
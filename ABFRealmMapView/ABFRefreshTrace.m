@@ -0,0 +1,847 @@
+//
+//  ABFRefreshTrace.m
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#import "ABFRefreshTrace.h"
+#import "ABFMapRefreshPipeline.h"
+#import "ABFLocationFetchRequest.h"
+#import "ABFMapLayer.h"
+#import "ABFHeatMapTileOverlay.h"
+
+#pragma mark - Constants
+
+static const uint32_t ABFRefreshTraceMagic = 0x41424654; // 'ABFT'
+static const uint32_t ABFRefreshTraceVersion = 2;
+
+static NSString * const ABFRefreshTraceErrorDomain = @"ABFRefreshTraceErrorDomain";
+
+/**
+ *  Header written before the event records, which are followed by the layer sets as a property list
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t eventSize;
+    uint32_t eventCount;
+    uint32_t layerSetsLength;
+} ABFRefreshTraceHeader;
+
+#pragma mark - Private Functions
+
+static NSError *ABFRefreshTraceError(NSString *reason)
+{
+    return [NSError errorWithDomain:ABFRefreshTraceErrorDomain
+                               code:1
+                           userInfo:@{NSLocalizedDescriptionKey : reason}];
+}
+
+#pragma mark - ABFRefreshTrace
+
+@interface ABFRefreshTrace ()
+
+@property (nonatomic, strong) NSMutableData *events;
+
+/**
+ *  The distinct arrays of layer identifiers, referenced by the 1-based layerSet of the events
+ */
+@property (nonatomic, strong) NSMutableArray<NSArray<NSString *> *> *layerSets;
+
+@property (nonatomic, assign) CFAbsoluteTime startTime;
+
+@end
+
+@implementation ABFRefreshTrace
+
+#pragma mark - Public Class
+
++ (instancetype)traceWithData:(NSData *)data
+                        error:(NSError **)error
+{
+    ABFRefreshTraceHeader header;
+    
+    if (data.length < sizeof(header)) {
+        if (error) {
+            *error = ABFRefreshTraceError(@"Trace data is too short");
+        }
+        
+        return nil;
+    }
+    
+    [data getBytes:&header length:sizeof(header)];
+    
+    NSUInteger eventsLength = (NSUInteger)header.eventCount * header.eventSize;
+    
+    if (header.magic != ABFRefreshTraceMagic ||
+        header.version != ABFRefreshTraceVersion ||
+        header.eventSize != sizeof(ABFRefreshTraceEvent) ||
+        data.length != sizeof(header) + eventsLength + header.layerSetsLength) {
+        
+        if (error) {
+            *error = ABFRefreshTraceError(@"Trace data is not a supported trace");
+        }
+        
+        return nil;
+    }
+    
+    NSArray *layerSets = @[];
+    
+    if (header.layerSetsLength > 0) {
+        NSData *layerSetsData = [data subdataWithRange:NSMakeRange(sizeof(header) + eventsLength, header.layerSetsLength)];
+        
+        layerSets = [NSPropertyListSerialization propertyListWithData:layerSetsData
+                                                              options:NSPropertyListImmutable
+                                                               format:NULL
+                                                                error:nil];
+        
+        if (![layerSets isKindOfClass:[NSArray class]]) {
+            if (error) {
+                *error = ABFRefreshTraceError(@"Trace data has invalid layer sets");
+            }
+            
+            return nil;
+        }
+    }
+    
+    ABFRefreshTrace *trace = [[self alloc] init];
+    
+    trace.events = [[data subdataWithRange:NSMakeRange(sizeof(header), eventsLength)] mutableCopy];
+    trace.layerSets = [layerSets mutableCopy];
+    
+    return trace;
+}
+
++ (instancetype)traceWithContentsOfURL:(NSURL *)url
+                                 error:(NSError **)error
+{
+    NSData *data = [NSData dataWithContentsOfURL:url options:0 error:error];
+    
+    if (!data) {
+        return nil;
+    }
+    
+    return [self traceWithData:data error:error];
+}
+
+#pragma mark - Init
+
+- (instancetype)init
+{
+    self = [super init];
+    
+    if (self) {
+        _events = [NSMutableData data];
+        _layerSets = [NSMutableArray array];
+        _startTime = CFAbsoluteTimeGetCurrent();
+        _maximumEventCount = 100000;
+    }
+    
+    return self;
+}
+
+#pragma mark - Public Instance
+
+- (NSData *)dataRepresentation
+{
+    @synchronized(self) {
+        NSData *layerSetsData = nil;
+        
+        if (self.layerSets.count > 0) {
+            layerSetsData = [NSPropertyListSerialization dataWithPropertyList:self.layerSets
+                                                                       format:NSPropertyListBinaryFormat_v1_0
+                                                                      options:0
+                                                                        error:nil];
+        }
+        
+        ABFRefreshTraceHeader header;
+        header.magic = ABFRefreshTraceMagic;
+        header.version = ABFRefreshTraceVersion;
+        header.eventSize = sizeof(ABFRefreshTraceEvent);
+        header.eventCount = (uint32_t)self.eventCount;
+        header.layerSetsLength = (uint32_t)layerSetsData.length;
+        
+        NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(header) + self.events.length + layerSetsData.length];
+        
+        [data appendBytes:&header length:sizeof(header)];
+        [data appendData:self.events];
+        
+        if (layerSetsData) {
+            [data appendData:layerSetsData];
+        }
+        
+        return data.copy;
+    }
+}
+
+- (BOOL)writeToURL:(NSURL *)url
+             error:(NSError **)error
+{
+    return [[self dataRepresentation] writeToURL:url options:NSDataWritingAtomic error:error];
+}
+
+- (void)recordViewportWithRegion:(MKCoordinateRegion)region
+                  visibleMapRect:(MKMapRect)visibleMapRect
+                       zoomScale:(MKZoomScale)zoomScale
+                            mode:(ABFRefreshTraceMode)mode
+                    memoryBudget:(NSUInteger)memoryBudget
+                layerIdentifiers:(NSArray<NSString *> *)layerIdentifiers
+{
+    ABFRefreshTraceEvent event = [self eventWithType:ABFRefreshTraceEventTypeViewport];
+    event.mode = mode;
+    event.layerSet = [self layerSetForLayerIdentifiers:layerIdentifiers];
+    event.zoomLevel = (uint32_t)ABFZoomLevelForVisibleMapRect(visibleMapRect);
+    event.viewport.region = region;
+    event.viewport.visibleMapRect = visibleMapRect;
+    event.viewport.zoomScale = zoomScale;
+    event.viewport.memoryBudget = memoryBudget;
+    
+    [self appendEvent:event];
+}
+
+- (NSUInteger)reserveViewportWithRegion:(MKCoordinateRegion)region
+                         visibleMapRect:(MKMapRect)visibleMapRect
+                              zoomScale:(MKZoomScale)zoomScale
+                       layerIdentifiers:(NSArray<NSString *> *)layerIdentifiers
+{
+    ABFRefreshTraceEvent event = [self eventWithType:ABFRefreshTraceEventTypeViewport];
+    event.mode = ABFRefreshTraceModeCancelled;
+    event.layerSet = [self layerSetForLayerIdentifiers:layerIdentifiers];
+    event.zoomLevel = (uint32_t)ABFZoomLevelForVisibleMapRect(visibleMapRect);
+    event.viewport.region = region;
+    event.viewport.visibleMapRect = visibleMapRect;
+    event.viewport.zoomScale = zoomScale;
+    
+    return [self appendEvent:event];
+}
+
+- (void)completeViewportAtIndex:(NSUInteger)index
+                           mode:(ABFRefreshTraceMode)mode
+                   memoryBudget:(NSUInteger)memoryBudget
+{
+    @synchronized(self) {
+        if (index >= self.eventCount) {
+            return;
+        }
+        
+        ABFRefreshTraceEvent *event = (ABFRefreshTraceEvent *)self.events.mutableBytes + index;
+        
+        if (event->type != ABFRefreshTraceEventTypeViewport) {
+            return;
+        }
+        
+        event->mode = mode;
+        event->viewport.memoryBudget = memoryBudget;
+    }
+}
+
+- (void)recordRealmChange:(RLMCollectionChange *)change
+               layerIndex:(NSUInteger)layerIndex
+{
+    ABFRefreshTraceEvent event = [self eventWithType:ABFRefreshTraceEventTypeRealmChange];
+    event.realmChange.insertionCount = (uint32_t)MIN(change.insertions.count, UINT32_MAX);
+    event.realmChange.deletionCount = (uint32_t)MIN(change.deletions.count, UINT32_MAX);
+    event.realmChange.modificationCount = (uint32_t)MIN(change.modifications.count, UINT32_MAX);
+    event.realmChange.layerIndex = (uint32_t)layerIndex;
+    
+    [self appendEvent:event];
+}
+
+- (NSArray<NSString *> *)layerIdentifiersForEvent:(ABFRefreshTraceEvent)event
+{
+    if (event.layerSet == 0) {
+        return nil;
+    }
+    
+    @synchronized(self) {
+        if (event.layerSet > self.layerSets.count) {
+            return nil;
+        }
+        
+        return self.layerSets[event.layerSet - 1];
+    }
+}
+
+- (void)recordRefreshWithMetrics:(ABFRefreshMetrics *)metrics
+{
+    ABFRefreshTraceMode mode = 0;
+    
+    if (metrics.clustered) {
+        mode |= ABFRefreshTraceModeClustered;
+    }
+    
+    if (metrics.split) {
+        mode |= ABFRefreshTraceModeSplit;
+    }
+    
+    if (metrics.aggregateOnly) {
+        mode |= ABFRefreshTraceModeAggregateOnly;
+    }
+    
+    ABFRefreshTraceEvent event = [self eventWithType:ABFRefreshTraceEventTypeRefresh];
+    event.mode = mode;
+    event.zoomLevel = (uint32_t)metrics.zoomLevel;
+    event.refresh.fetchDuration = metrics.fetchDuration;
+    event.refresh.diffDuration = metrics.diffDuration;
+    event.refresh.applyDuration = metrics.applyDuration;
+    event.refresh.totalDuration = metrics.totalDuration;
+    event.refresh.objectCount = (uint32_t)MIN(metrics.objectCount, UINT32_MAX);
+    event.refresh.annotationCount = (uint32_t)MIN(metrics.annotationCount, UINT32_MAX);
+    
+    [self appendEvent:event];
+}
+
+- (void)enumerateEventsUsingBlock:(void (^)(ABFRefreshTraceEvent, BOOL *))block
+{
+    NSData *events = nil;
+    
+    @synchronized(self) {
+        events = self.events.copy;
+    }
+    
+    const ABFRefreshTraceEvent *records = events.bytes;
+    NSUInteger count = events.length / sizeof(ABFRefreshTraceEvent);
+    
+    BOOL stop = NO;
+    
+    for (NSUInteger i = 0; i < count && !stop; i++) {
+        block(records[i], &stop);
+    }
+}
+
+#pragma mark - Getters
+
+- (NSUInteger)eventCount
+{
+    @synchronized(self) {
+        return self.events.length / sizeof(ABFRefreshTraceEvent);
+    }
+}
+
+#pragma mark - Private Instance
+
+- (ABFRefreshTraceEvent)eventWithType:(ABFRefreshTraceEventType)type
+{
+    ABFRefreshTraceEvent event;
+    memset(&event, 0, sizeof(event));
+    
+    event.type = type;
+    event.timestamp = CFAbsoluteTimeGetCurrent() - self.startTime;
+    
+    return event;
+}
+
+- (uint16_t)layerSetForLayerIdentifiers:(NSArray<NSString *> *)layerIdentifiers
+{
+    if (layerIdentifiers.count == 0) {
+        return 0;
+    }
+    
+    @synchronized(self) {
+        NSUInteger index = [self.layerSets indexOfObject:layerIdentifiers];
+        
+        if (index == NSNotFound) {
+            // The layer set can't be referenced, record the refresh as not layered
+            if (self.layerSets.count >= UINT16_MAX) {
+                return 0;
+            }
+            
+            [self.layerSets addObject:layerIdentifiers.copy];
+            
+            index = self.layerSets.count - 1;
+        }
+        
+        return (uint16_t)(index + 1);
+    }
+}
+
+/**
+ *  @return the index of the event, NSNotFound if the trace is full
+ */
+- (NSUInteger)appendEvent:(ABFRefreshTraceEvent)event
+{
+    @synchronized(self) {
+        NSUInteger index = self.eventCount;
+        
+        if (index >= self.maximumEventCount) {
+            return NSNotFound;
+        }
+        
+        [self.events appendBytes:&event length:sizeof(event)];
+        
+        return index;
+    }
+}
+
+@end
+
+#pragma mark - ABFLatencyDistribution
+
+@implementation ABFLatencyDistribution
+
+#pragma mark - Public Class
+
++ (instancetype)distributionWithSamples:(NSArray<NSNumber *> *)samples
+{
+    ABFLatencyDistribution *distribution = [[self alloc] init];
+    distribution->_samples = [samples sortedArrayUsingSelector:@selector(compare:)];
+    
+    return distribution;
+}
+
++ (instancetype)recordedDistributionForTrace:(ABFRefreshTrace *)trace
+{
+    NSMutableArray *samples = [NSMutableArray array];
+    
+    [trace enumerateEventsUsingBlock:^(ABFRefreshTraceEvent event, BOOL *stop) {
+        if (event.type == ABFRefreshTraceEventTypeRefresh) {
+            [samples addObject:@(event.refresh.totalDuration)];
+        }
+    }];
+    
+    return [self distributionWithSamples:samples];
+}
+
++ (instancetype)distributionWithContentsOfURL:(NSURL *)url
+                                        error:(NSError **)error
+{
+    NSData *data = [NSData dataWithContentsOfURL:url options:0 error:error];
+    
+    if (!data) {
+        return nil;
+    }
+    
+    id samples = [NSPropertyListSerialization propertyListWithData:data
+                                                           options:NSPropertyListImmutable
+                                                            format:NULL
+                                                             error:error];
+    
+    if (![samples isKindOfClass:[NSArray class]]) {
+        if (error && !*error) {
+            *error = ABFRefreshTraceError(@"Latency distribution file does not contain samples");
+        }
+        
+        return nil;
+    }
+    
+    return [self distributionWithSamples:samples];
+}
+
+#pragma mark - Public Instance
+
+- (BOOL)writeToURL:(NSURL *)url
+             error:(NSError **)error
+{
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:self.samples
+                                                              format:NSPropertyListBinaryFormat_v1_0
+                                                             options:0
+                                                               error:error];
+    
+    return [data writeToURL:url options:NSDataWritingAtomic error:error];
+}
+
+- (NSTimeInterval)latencyAtPercentile:(double)percentile
+{
+    NSUInteger count = self.samples.count;
+    
+    if (count == 0) {
+        return 0;
+    }
+    
+    // Nearest-rank
+    double rank = ceil(MIN(MAX(percentile, 0), 100) / 100.0 * count);
+    NSUInteger index = MIN(MAX((NSUInteger)rank, 1), count) - 1;
+    
+    return self.samples[index].doubleValue;
+}
+
+- (BOOL)isRegressionComparedToBaseline:(ABFLatencyDistribution *)baseline
+                             tolerance:(double)tolerance
+{
+    return self.p95 > baseline.p95 * (1 + tolerance);
+}
+
+- (NSString *)comparisonDescriptionWithBaseline:(ABFLatencyDistribution *)baseline
+{
+    NSMutableString *description = [NSMutableString stringWithFormat:@"%lu samples (baseline %lu)\n",
+                                    (unsigned long)self.samples.count,
+                                    (unsigned long)baseline.samples.count];
+    
+    NSArray *names = @[@"mean", @"p50", @"p95", @"p99", @"max"];
+    NSArray *values = @[@(self.mean), @(self.p50), @(self.p95), @(self.p99), @(self.max)];
+    NSArray *baselineValues = @[@(baseline.mean), @(baseline.p50), @(baseline.p95), @(baseline.p99), @(baseline.max)];
+    
+    for (NSUInteger i = 0; i < names.count; i++) {
+        double value = [values[i] doubleValue];
+        double baselineValue = [baselineValues[i] doubleValue];
+        double change = baselineValue > 0 ? (value - baselineValue) / baselineValue * 100 : 0;
+        
+        [description appendFormat:@"%@: %.2fms (baseline %.2fms, %+.1f%%)\n",
+         names[i], value * 1000, baselineValue * 1000, change];
+    }
+    
+    return description.copy;
+}
+
+#pragma mark - Getters
+
+- (NSTimeInterval)mean
+{
+    if (self.samples.count == 0) {
+        return 0;
+    }
+    
+    return [[self.samples valueForKeyPath:@"@avg.doubleValue"] doubleValue];
+}
+
+- (NSTimeInterval)p50
+{
+    return [self latencyAtPercentile:50];
+}
+
+- (NSTimeInterval)p95
+{
+    return [self latencyAtPercentile:95];
+}
+
+- (NSTimeInterval)p99
+{
+    return [self latencyAtPercentile:99];
+}
+
+- (NSTimeInterval)max
+{
+    return self.samples.lastObject.doubleValue;
+}
+
+@end
+
+#pragma mark - ABFRefreshTraceReplayer
+
+@interface ABFRefreshTraceReplayer ()
+
+@property (nonatomic, strong) RLMRealmConfiguration *realmConfiguration;
+
+@property (nonatomic, strong) NSString *entityName;
+
+@property (nonatomic, strong) NSString *latitudeKeyPath;
+
+@property (nonatomic, strong) NSString *longitudeKeyPath;
+
+@end
+
+@implementation ABFRefreshTraceReplayer
+
+#pragma mark - Init
+
+- (instancetype)initWithTrace:(ABFRefreshTrace *)trace
+           realmConfiguration:(RLMRealmConfiguration *)realmConfiguration
+                   entityName:(NSString *)entityName
+              latitudeKeyPath:(NSString *)latitudeKeyPath
+             longitudeKeyPath:(NSString *)longitudeKeyPath
+{
+    self = [super init];
+    
+    if (self) {
+        _trace = trace;
+        _realmConfiguration = realmConfiguration;
+        _entityName = entityName;
+        _latitudeKeyPath = latitudeKeyPath;
+        _longitudeKeyPath = longitudeKeyPath;
+        _fetchResultsController = [[ABFLocationFetchedResultsController alloc] init];
+        _contentScaleFactor = [UIScreen mainScreen].scale;
+        
+        RLMRealm *realm = [RLMRealm realmWithConfiguration:realmConfiguration error:nil];
+        
+        if (realm) {
+            _heatMapOverlay = [[ABFHeatMapTileOverlay alloc] initWithEntityName:entityName
+                                                                        inRealm:realm
+                                                                latitudeKeyPath:latitudeKeyPath
+                                                               longitudeKeyPath:longitudeKeyPath];
+        }
+    }
+    
+    return self;
+}
+
+#pragma mark - Public Instance
+
+- (ABFLatencyDistribution *)replay
+{
+    NSMutableArray *samples = [NSMutableArray array];
+    
+    RLMRealm *realm = [RLMRealm realmWithConfiguration:self.realmConfiguration error:nil];
+    
+    if (!realm) {
+        return [ABFLatencyDistribution distributionWithSamples:samples];
+    }
+    
+    // Refreshes triggered by Realm changes are recorded as viewports too, after the change
+    [self.trace enumerateEventsUsingBlock:^(ABFRefreshTraceEvent event, BOOL *stop) {
+        @autoreleasepool {
+            if (event.type == ABFRefreshTraceEventTypeViewport &&
+                !(event.mode & ABFRefreshTraceModeCancelled)) {
+                [samples addObject:@([self replayViewport:event inRealm:realm])];
+            }
+            else if (event.type == ABFRefreshTraceEventTypeRealmChange) {
+                [self replayRealmChange:event inRealm:realm];
+            }
+        }
+    }];
+    
+    return [ABFLatencyDistribution distributionWithSamples:samples];
+}
+
+#pragma mark - Private Instance
+
+- (NSTimeInterval)replayViewport:(ABFRefreshTraceEvent)event
+                         inRealm:(RLMRealm *)realm
+{
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    if (event.mode & ABFRefreshTraceModeHeatMap) {
+        [self renderHeatMapTilesForViewport:event];
+        
+        return CFAbsoluteTimeGetCurrent() - start;
+    }
+    
+    ABFLocationFetchedResultsController *fetchResultsController = self.fetchResultsController;
+    
+    NSArray<NSString *> *layerIdentifiers = [self.trace layerIdentifiersForEvent:event];
+    
+    if (layerIdentifiers) {
+        NSArray<ABFMapLayer *> *layers = [self layersWithIdentifiers:layerIdentifiers];
+        
+        // None of the recorded layers are known
+        if (layers.count == 0) {
+            return 0;
+        }
+        
+        NSMutableArray *fetchRequests = [NSMutableArray arrayWithCapacity:layers.count];
+        
+        for (ABFMapLayer *layer in layers) {
+            [fetchRequests addObject:[self fetchRequestWithEntityName:layer.entityName
+                                                      latitudeKeyPath:layer.latitudeKeyPath
+                                                     longitudeKeyPath:layer.longitudeKeyPath
+                                                        basePredicate:layer.basePredicate
+                                                            forRegion:event.viewport.region
+                                                              inRealm:realm]];
+        }
+        
+        [fetchResultsController updateLayers:layers fetchRequests:fetchRequests];
+    }
+    else {
+        ABFLocationFetchRequest *fetchRequest = [self fetchRequestWithEntityName:self.entityName
+                                                                 latitudeKeyPath:self.latitudeKeyPath
+                                                                longitudeKeyPath:self.longitudeKeyPath
+                                                                   basePredicate:self.basePredicate
+                                                                       forRegion:event.viewport.region
+                                                                         inRealm:realm];
+        
+        [fetchResultsController updateLocationFetchRequest:fetchRequest
+                                              titleKeyPath:self.titleKeyPath
+                                           subtitleKeyPath:self.subtitleKeyPath];
+    }
+    
+    // The budget and pressure decide between aggregate-only and full clustering, as they did when recorded
+    fetchResultsController.memoryBudget = (NSUInteger)event.viewport.memoryBudget;
+    fetchResultsController.underMemoryPressure = (event.mode & ABFRefreshTraceModeUnderMemoryPressure) != 0;
+    
+    // The split reuses the objects of the previous replayed fetch, like the map view did
+    if ((event.mode & ABFRefreshTraceModeSplit) &&
+        [fetchResultsController performSplitFetchForRegion:event.viewport.region]) {
+        
+        return CFAbsoluteTimeGetCurrent() - start;
+    }
+    
+    if (event.mode & ABFRefreshTraceModeClustered) {
+        [fetchResultsController performClusteringFetchForVisibleMapRect:event.viewport.visibleMapRect
+                                                               zoomScale:event.viewport.zoomScale];
+    }
+    else {
+        [fetchResultsController performFetch];
+    }
+    
+    return CFAbsoluteTimeGetCurrent() - start;
+}
+
+- (void)replayRealmChange:(ABFRefreshTraceEvent)event
+                  inRealm:(RLMRealm *)realm
+{
+    ABFLocationFetchedResultsController *fetchResultsController = self.fetchResultsController;
+    
+    NSArray *fetchRequests = fetchResultsController.layerFetchRequests;
+    
+    if (!fetchRequests) {
+        fetchRequests = fetchResultsController.fetchRequest ? @[fetchResultsController.fetchRequest] : @[];
+    }
+    
+    // Changes before the first replayed fetch
+    if (event.realmChange.layerIndex >= fetchRequests.count) {
+        return;
+    }
+    
+    ABFLocationFetchRequest *fetchRequest = fetchRequests[event.realmChange.layerIndex];
+    
+    [realm beginWriteTransaction];
+    
+    // Don't leave the Realm in the transaction, the following events couldn't be replayed
+    @try {
+        if (self.realmChangeBlock) {
+            self.realmChangeBlock(realm, fetchRequest, event);
+        }
+        else {
+            [self writeRealmChange:event forFetchRequest:fetchRequest inRealm:realm];
+        }
+        
+        [realm commitWriteTransaction];
+    }
+    @catch (NSException *exception) {
+        if (realm.inWriteTransaction) {
+            [realm cancelWriteTransaction];
+        }
+        
+        @throw;
+    }
+    
+    // The map view reloads the heat map tiles after a change
+    [self.heatMapOverlay reloadTiles];
+}
+
+- (void)writeRealmChange:(ABFRefreshTraceEvent)event
+         forFetchRequest:(ABFLocationFetchRequest *)fetchRequest
+                 inRealm:(RLMRealm *)realm
+{
+    RLMResults *fetchResults = fetchRequest.fetchObjects;
+    
+    NSUInteger count = fetchResults.count;
+    
+    if (count == 0) {
+        return;
+    }
+    
+    NSString *latitudeKeyPath = fetchRequest.latitudeKeyPath;
+    
+    NSUInteger modificationCount = MIN(event.realmChange.modificationCount, count);
+    
+    for (NSUInteger i = 0; i < modificationCount; i++) {
+        RLMObject *object = fetchResults[i];
+        
+        [object setValue:[object valueForKeyPath:latitudeKeyPath] forKeyPath:latitudeKeyPath];
+    }
+    
+    NSArray *deletedObjects = [self objectsInFetchResults:fetchResults
+                                                    count:MIN(event.realmChange.deletionCount, count)];
+    
+    // Copies would violate a primary key
+    if (!realm.schema[fetchRequest.entityName].primaryKeyProperty) {
+        NSArray *insertedValues = [self objectsInFetchResults:fetchResults
+                                                        count:MIN(event.realmChange.insertionCount, count)];
+        
+        for (RLMObject *value in insertedValues) {
+            [realm createObject:fetchRequest.entityName withValue:value];
+        }
+    }
+    
+    [realm deleteObjects:deletedObjects];
+}
+
+- (NSArray *)objectsInFetchResults:(RLMResults *)fetchResults
+                             count:(NSUInteger)count
+{
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:count];
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        [objects addObject:fetchResults[i]];
+    }
+    
+    return objects.copy;
+}
+
+- (void)renderHeatMapTilesForViewport:(ABFRefreshTraceEvent)event
+{
+    ABFHeatMapTileOverlay *heatMapOverlay = self.heatMapOverlay;
+    
+    if (!heatMapOverlay) {
+        return;
+    }
+    
+    heatMapOverlay.basePredicate = self.basePredicate;
+    
+    // The zoom MapKit displays the tiles at for the zoom scale
+    double tilesAcrossWorld = MKMapSizeWorld.width * event.viewport.zoomScale / heatMapOverlay.tileSize.width;
+    
+    NSInteger z = MIN(MAX(lround(log2(tilesAcrossWorld)), heatMapOverlay.minimumZ), heatMapOverlay.maximumZ);
+    NSInteger tileCount = 1 << z;
+    
+    double tileMapSize = MKMapSizeWorld.width / tileCount;
+    
+    MKMapRect visibleMapRect = event.viewport.visibleMapRect;
+    
+    NSInteger minX = (NSInteger)floor(MKMapRectGetMinX(visibleMapRect) / tileMapSize);
+    NSInteger maxX = (NSInteger)ceil(MKMapRectGetMaxX(visibleMapRect) / tileMapSize) - 1;
+    NSInteger minY = MAX((NSInteger)floor(MKMapRectGetMinY(visibleMapRect) / tileMapSize), 0);
+    NSInteger maxY = MIN((NSInteger)ceil(MKMapRectGetMaxY(visibleMapRect) / tileMapSize) - 1, tileCount - 1);
+    
+    dispatch_group_t group = dispatch_group_create();
+    
+    for (NSInteger y = minY; y <= maxY; y++) {
+        for (NSInteger x = minX; x <= maxX; x++) {
+            MKTileOverlayPath path;
+            path.x = ((x % tileCount) + tileCount) % tileCount;
+            path.y = y;
+            path.z = z;
+            path.contentScaleFactor = self.contentScaleFactor;
+            
+            dispatch_group_enter(group);
+            
+            [heatMapOverlay loadTileAtPath:path result:^(NSData *tileData, NSError *error) {
+                dispatch_group_leave(group);
+            }];
+        }
+    }
+    
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+}
+
+- (NSArray<ABFMapLayer *> *)layersWithIdentifiers:(NSArray<NSString *> *)layerIdentifiers
+{
+    NSMutableArray *layers = [NSMutableArray arrayWithCapacity:layerIdentifiers.count];
+    
+    for (NSString *layerIdentifier in layerIdentifiers) {
+        for (ABFMapLayer *layer in self.layers) {
+            if ([layer.identifier isEqualToString:layerIdentifier]) {
+                [layers addObject:layer];
+                
+                break;
+            }
+        }
+    }
+    
+    return layers.copy;
+}
+
+- (ABFLocationFetchRequest *)fetchRequestWithEntityName:(NSString *)entityName
+                                        latitudeKeyPath:(NSString *)latitudeKeyPath
+                                       longitudeKeyPath:(NSString *)longitudeKeyPath
+                                          basePredicate:(NSPredicate *)basePredicate
+                                              forRegion:(MKCoordinateRegion)region
+                                                inRealm:(RLMRealm *)realm
+{
+    ABFLocationFetchRequest *fetchRequest =
+    [ABFLocationFetchRequest locationFetchRequestWithEntityName:entityName
+                                                        inRealm:realm
+                                                latitudeKeyPath:latitudeKeyPath
+                                               longitudeKeyPath:longitudeKeyPath
+                                                      forRegion:region];
+    
+    if (basePredicate) {
+        fetchRequest.predicate = [NSCompoundPredicate andPredicateWithSubpredicates:@[fetchRequest.predicate,basePredicate]];
+    }
+    
+    return fetchRequest;
+}
+
+@end
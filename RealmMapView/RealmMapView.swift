@@ -13,10 +13,17 @@ import ABFRealmMapView
 public typealias ClusterAnnotationView = ABFClusterAnnotationView
 public typealias LocationSafeRealmObject = ABFLocationSafeRealmObject
 public typealias LocationFetchedResultsController = ABFLocationFetchedResultsController
+public typealias LocationSortDescriptor = ABFLocationSortDescriptor
 public typealias ZoomLevel = ABFZoomLevel
 public typealias ResultsLimit = ABFResultsLimit
 public typealias Annotation = ABFAnnotation
 public typealias AnnotationType = ABFAnnotationType
+public typealias MapRefreshPipeline = ABFMapRefreshPipeline
+public typealias RefreshMetrics = ABFRefreshMetrics
+public typealias HeatMapTileOverlay = ABFHeatMapTileOverlay
+public typealias MapLayer = ABFMapLayer
+public typealias CircleLocationFetchRequest = ABFCircleLocationFetchRequest
+public typealias PolygonLocationFetchRequest = ABFPolygonLocationFetchRequest
 
 /**
 The RealmMapView class creates an interface object that inherits MKMapView and manages fetching and displaying annotations for a Realm Swift object class that contains coordinate data.
@@ -30,6 +37,7 @@ open class RealmMapView: MKMapView {
     open var realmConfiguration: Realm.Configuration {
         set {
             self.internalConfiguration = newValue
+            self.refreshPipeline.realmConfiguration = ObjectiveCSupport.convert(object: newValue)
         }
         get {
             if let configuration = self.internalConfiguration {
@@ -45,41 +53,106 @@ open class RealmMapView: MKMapView {
         return try! Realm(configuration: self.realmConfiguration)
     }
     
-    /// The internal controller that fetches the Realm objects
-    open var fetchedResultsController: LocationFetchedResultsController = {
-        let controller = ABFLocationFetchedResultsController()
-        
-        return controller
+    /// The pipeline that performs the refreshes for the map view
+    ///
+    /// Use to observe the refresh metrics. The map view's settings are stored on it, so it can't be replaced.
+    open private(set) lazy var refreshPipeline: MapRefreshPipeline = {
+        return ABFMapRefreshPipeline(mapView: self)
     }()
     
+    /// The internal controller that fetches the Realm objects
+    ///
+    /// Owned by the refresh pipeline, so it can no longer be assigned (see Upgrading in the README).
+    open var fetchedResultsController: LocationFetchedResultsController {
+        return self.refreshPipeline.fetchResultsController
+    }
+    
     /// The Realm object's name being fetched for the map view
-    @IBInspectable open var entityName: String?
+    @IBInspectable open var entityName: String? {
+        set {
+            self.refreshPipeline.entityName = newValue
+        }
+        get {
+            return self.refreshPipeline.entityName
+        }
+    }
     
     /// The key path on fetched Realm objects for the latitude value
-    @IBInspectable open var latitudeKeyPath: String?
+    @IBInspectable open var latitudeKeyPath: String? {
+        set {
+            self.refreshPipeline.latitudeKeyPath = newValue
+        }
+        get {
+            return self.refreshPipeline.latitudeKeyPath
+        }
+    }
     
     /// The key path on fetched Realm objects for the longitude value
-    @IBInspectable open var longitudeKeyPath: String?
+    @IBInspectable open var longitudeKeyPath: String? {
+        set {
+            self.refreshPipeline.longitudeKeyPath = newValue
+        }
+        get {
+            return self.refreshPipeline.longitudeKeyPath
+        }
+    }
     
     /// The key path on fetched Realm objects for the title of the annotation view
     ///
     /// If nil, then no title will be shown
-    @IBInspectable open var titleKeyPath: String?
+    @IBInspectable open var titleKeyPath: String? {
+        set {
+            self.refreshPipeline.titleKeyPath = newValue
+        }
+        get {
+            return self.refreshPipeline.titleKeyPath
+        }
+    }
     
     /// The key path on fetched Realm objects for the subtitle of the annotation view
     ///
     /// If nil, then no subtitle
-    @IBInspectable open var subtitleKeyPath: String?
+    @IBInspectable open var subtitleKeyPath: String? {
+        set {
+            self.refreshPipeline.subtitleKeyPath = newValue
+        }
+        get {
+            return self.refreshPipeline.subtitleKeyPath
+        }
+    }
     
     /// Designates if the map view will cluster the annotations
-    @IBInspectable open var clusterAnnotations = true
+    @IBInspectable open var clusterAnnotations: Bool {
+        set {
+            self.refreshPipeline.clusterAnnotations = newValue
+        }
+        get {
+            return self.refreshPipeline.clusterAnnotations
+        }
+    }
     
     /// Designates if the map view automatically refreshes when the map moves
-    @IBInspectable open var autoRefresh = true
+    ///
+    /// Also will respond to change notifications in Realm to autorefresh
+    @IBInspectable open var autoRefresh: Bool {
+        set {
+            self.refreshPipeline.autoRefresh = newValue
+        }
+        get {
+            return self.refreshPipeline.autoRefresh
+        }
+    }
     
     /// Designates if the map view will zoom to a region that contains all points
     /// on the first refresh of the map annotations (presumably on viewWillAppear)
-    @IBInspectable open var zoomOnFirstRefresh = true
+    @IBInspectable open var zoomOnFirstRefresh: Bool {
+        set {
+            self.refreshPipeline.zoomOnFirstRefresh = newValue
+        }
+        get {
+            return self.refreshPipeline.zoomOnFirstRefresh
+        }
+    }
     
     /// If enabled, annotation views will be animated when added to the map.
     ///
@@ -90,6 +163,25 @@ open class RealmMapView: MKMapView {
     /// The annotation must have a title for the callout to be shown.
     @IBInspectable open var canShowCallout = true
     
+    /// Designates if the map view will display a heat map of the object density instead of annotations
+    ///
+    /// The heat map is not supported with layers: while layers is set, annotations are displayed and heatMap is ignored.
+    ///
+    /// Default is NO
+    @IBInspectable open var heatMap: Bool {
+        set {
+            self.refreshPipeline.heatMap = newValue
+        }
+        get {
+            return self.refreshPipeline.heatMap
+        }
+    }
+    
+    /// The overlay that renders the heat map tiles when heatMap is enabled, otherwise nil.
+    open var heatMapOverlay: HeatMapTileOverlay? {
+        return self.refreshPipeline.heatMapOverlay
+    }
+    
     /// Max zoom level of the map view to perform clustering on.
     ///
     /// ABFZoomLevel is inherited from MapKit's Google days:
@@ -97,7 +189,28 @@ open class RealmMapView: MKMapView {
     /// 20 is max zoom
     ///
     /// Default is 20, which means clustering will occur at every zoom level if clusterAnnotations is YES
-    open var maxZoomLevelForClustering: ZoomLevel = 20
+    open var maxZoomLevelForClustering: ZoomLevel {
+        set {
+            self.refreshPipeline.maxZoomLevelForClustering = newValue
+        }
+        get {
+            return self.refreshPipeline.maxZoomLevelForClustering
+        }
+    }
+    
+    /// Number of zoom levels below maxZoomLevelForClustering the map must zoom out to before clustering resumes.
+    ///
+    /// Prevents switching between clusters and unique annotations while pinching around the threshold.
+    ///
+    /// Default is 1
+    open var clusteringZoomHysteresis: ZoomLevel {
+        set {
+            self.refreshPipeline.clusteringZoomHysteresis = newValue
+        }
+        get {
+            return self.refreshPipeline.clusteringZoomHysteresis
+        }
+    }
     
     /// The limit on how many results from Realm will be added to the map.
     ///
@@ -113,77 +226,63 @@ open class RealmMapView: MKMapView {
         }
     }
     
+    /// Approximate number of bytes the fetched results controller may hold for the map.
+    ///
+    /// When a fetch would exceed the budget, the map shows aggregate-only clusters (clusters without their safe objects).
+    ///
+    /// Default is 0, or no budget.
+    open var memoryBudget: UInt {
+        set {
+            self.fetchedResultsController.memoryBudget = newValue
+        }
+        get {
+            return self.fetchedResultsController.memoryBudget
+        }
+    }
+    
+    /// Estimate of the bytes currently held by the fetched results controller.
+    open var memoryUsage: UInt {
+        return self.fetchedResultsController.memoryUsage
+    }
+    
     /// Use this property to filter items found by the map. This predicate will be included, via AND,
     /// along with the generated predicate for the location bounding box.
-    open var basePredicate: NSPredicate?
+    open var basePredicate: NSPredicate? {
+        set {
+            self.refreshPipeline.basePredicate = newValue
+        }
+        get {
+            return self.refreshPipeline.basePredicate
+        }
+    }
+    
+    /// Sorts the objects by distance, which decides the objects kept when resultsLimit is set.
+    open var sortDescriptor: LocationSortDescriptor? {
+        set {
+            self.refreshPipeline.sortDescriptor = newValue
+        }
+        get {
+            return self.refreshPipeline.sortDescriptor
+        }
+    }
+    
+    /// Layers to display instead of entityName, each with its own entity, key paths, predicate and color.
+    ///
+    /// The layers are fetched concurrently and clustered together. Annotation views use the color of the annotation's layer (for clusters, the layer with the most objects), views of layers without a color keep their own. While layers is set, heatMap is ignored.
+    open var layers: [MapLayer]? {
+        set {
+            self.refreshPipeline.layers = newValue
+        }
+        get {
+            return self.refreshPipeline.layers
+        }
+    }
     
     // MARK: Functions
     
     /// Performs a fresh fetch for Realm objects based on the current visible map rect
     open func refreshMapView() {
-        objc_sync_enter(self)
-        
-        self.mapQueue.cancelAllOperations()
-        
-        let currentRegion = self.region
-        
-        let rlmConfig = ObjectiveCSupport.convert(object: self.realmConfiguration)
-        
-        if let rlmRealm = try? RLMRealm(configuration: rlmConfig) {
-            
-            let fetchRequest = ABFLocationFetchRequest(entityName: self.entityName!, in: rlmRealm, latitudeKeyPath: self.latitudeKeyPath!, longitudeKeyPath: self.longitudeKeyPath!, for: currentRegion)
-            fetchRequest.predicate = NSPredicateForCoordinateRegion(currentRegion, self.latitudeKeyPath!, self.longitudeKeyPath!)
-
-            var predicates = [NSPredicate]()
-            if let basePred = self.basePredicate {
-                predicates.append(basePred)
-            }
-            if let fetchPred = fetchRequest.predicate {
-                predicates.append(fetchPred)
-            }
-            
-            if !predicates.isEmpty {
-                let compPred = NSCompoundPredicate(andPredicateWithSubpredicates: predicates)
-                fetchRequest.predicate = compPred
-            }
-            
-            self.fetchedResultsController.update(fetchRequest, titleKeyPath: self.titleKeyPath, subtitleKeyPath: self.subtitleKeyPath)
-            
-            let visibleMapRect = self.visibleMapRect
-            
-            let currentZoomLevel = ABFZoomLevelForVisibleMapRect(visibleMapRect)
-            
-            let refreshOperation: BlockOperation
-            if self.clusterAnnotations && currentZoomLevel <= self.maxZoomLevelForClustering {
-                
-                let zoomScale = MKZoomScaleForMapView(self)
-                
-                refreshOperation = BlockOperation { [weak self] in
-                    guard let strongSelf = self else {
-                        return
-                    }
-                    strongSelf.fetchedResultsController.performClusteringFetch(forVisibleMapRect: visibleMapRect, zoomScale: zoomScale)
-                    
-                    let annotations = strongSelf.fetchedResultsController.annotations
-                    strongSelf.addAnnotationsToMapView(annotations)
-                }
-            }
-            else {
-                refreshOperation = BlockOperation { [weak self] in
-                    guard let strongSelf = self else {
-                        return
-                    }
-                    strongSelf.fetchedResultsController.performFetch()
-                    
-                    let annotations = strongSelf.fetchedResultsController.annotations
-                    strongSelf.addAnnotationsToMapView(annotations)
-                }
-            }
-            
-            self.mapQueue.addOperation(refreshOperation)
-        }
-        
-        objc_sync_exit(self)
+        self.refreshPipeline.refresh()
     }
     
     // MARK: Initialization
@@ -213,65 +312,10 @@ open class RealmMapView: MKMapView {
     fileprivate var internalConfiguration: Realm.Configuration?
     
     fileprivate let ABFAnnotationViewReuseId = "ABFAnnotationViewReuseId"
-    
-    fileprivate let mapQueue: OperationQueue = {
-        let queue = OperationQueue()
-        queue.maxConcurrentOperationCount = 1
-        
-        return queue
-    }()
+    fileprivate let ABFLayerAnnotationViewReuseId = "ABFLayerAnnotationViewReuseId"
     
     weak fileprivate var externalDelegate: MKMapViewDelegate?
     
-    fileprivate func addAnnotationsToMapView(_ annotations: Set<ABFAnnotation>) {
-        let safeObjects = self.fetchedResultsController.safeObjects
-        DispatchQueue.main.async { [weak self] in
-            guard let strongSelf = self else {
-                return
-            }
-            
-            let currentAnnotations: NSMutableSet
-            if strongSelf.annotations.isEmpty {
-                currentAnnotations = NSMutableSet()
-            } else {
-                currentAnnotations = NSMutableSet(array: strongSelf.annotations)
-            }
-            
-            let newAnnotations = annotations
-            
-            let toKeep = NSMutableSet(set: currentAnnotations)
-            
-            toKeep.intersect(newAnnotations as Set<NSObject>)
-            
-            let toAdd = NSMutableSet(set: newAnnotations)
-            
-            toAdd.minus(toKeep as Set<NSObject>)
-            
-            let toRemove = NSMutableSet(set: currentAnnotations)
-            
-            toRemove.minus(newAnnotations)
-                
-            if strongSelf.zoomOnFirstRefresh && safeObjects.count > 0 {
-                
-                strongSelf.zoomOnFirstRefresh = false
-                
-                let region = strongSelf.coordinateRegion(safeObjects)
-                
-                strongSelf.setRegion(region, animated: true)
-            }
-            else {
-                if let addAnnotations = toAdd.allObjects as? [MKAnnotation] {
-                    
-                    if let removeAnnotations = toRemove.allObjects as? [MKAnnotation] {
-                        
-                        strongSelf.addAnnotations(addAnnotations)
-                        strongSelf.removeAnnotations(removeAnnotations)
-                    }
-                }
-            }
-        }
-    }
-    
     fileprivate func addAnimation(_ view: UIView) {
         view.transform = CGAffineTransform.identity.scaledBy(x: 0.05, y: 0.05)
         
@@ -287,25 +331,6 @@ open class RealmMapView: MKMapView {
             completion: nil
         )
     }
-    
-    fileprivate func coordinateRegion(_ safeObjects: [ABFLocationSafeRealmObject]) -> MKCoordinateRegion {
-        var rect = MKMapRectNull
-        
-        for safeObject in safeObjects {
-            let point = MKMapPointForCoordinate(safeObject.coordinate)
-            
-            rect = MKMapRectUnion(rect, MKMapRectMake(point.x, point.y, 0, 0))
-        }
-        
-        var region = MKCoordinateRegionForMapRect(rect)
-        
-        region = self.regionThatFits(region)
-        
-        region.span.latitudeDelta *= 1.3
-        region.span.longitudeDelta *= 1.3
-        
-        return region
-    }
 }
 
 /**
@@ -354,15 +379,24 @@ extension RealmMapView: MKMapViewDelegate {
         }
         else if let fetchedAnnotation = annotation as? ABFAnnotation {
             
-            var annotationView = mapView.dequeueReusableAnnotationView(withIdentifier: ABFAnnotationViewReuseId) as! ABFClusterAnnotationView?
+            let layerColor = self.refreshPipeline.layer(for: fetchedAnnotation)?.color
+            
+            // Views colored by a layer are reused separately, so the other views keep their own color
+            let reuseIdentifier = layerColor != nil ? ABFLayerAnnotationViewReuseId : ABFAnnotationViewReuseId
+            
+            var annotationView = mapView.dequeueReusableAnnotationView(withIdentifier: reuseIdentifier) as! ABFClusterAnnotationView?
             
             if annotationView == nil {
-                annotationView = ABFClusterAnnotationView(annotation: fetchedAnnotation, reuseIdentifier: ABFAnnotationViewReuseId)
+                annotationView = ABFClusterAnnotationView(annotation: fetchedAnnotation, reuseIdentifier: reuseIdentifier)
                 
                 annotationView!.canShowCallout = self.canShowCallout
             }
             
-            annotationView!.count = UInt(fetchedAnnotation.safeObjects.count)
+            if let layerColor = layerColor {
+                annotationView!.color = layerColor
+            }
+            
+            annotationView!.count = fetchedAnnotation.objectCount
             annotationView!.annotation = fetchedAnnotation
             
             return annotationView!
@@ -419,7 +453,14 @@ extension RealmMapView: MKMapViewDelegate {
     }
     
     public func mapView(_ mapView: MKMapView, rendererFor overlay: MKOverlay) -> MKOverlayRenderer {
-        return (self.externalDelegate?.mapView?(mapView, rendererFor: overlay))!
+        if let delegate = self.externalDelegate, let renderer = delegate.mapView?(mapView, rendererFor: overlay) {
+            return renderer
+        }
+        else if let heatMapOverlay = overlay as? ABFHeatMapTileOverlay {
+            return MKTileOverlayRenderer(tileOverlay: heatMapOverlay)
+        }
+        
+        return MKOverlayRenderer(overlay: overlay)
     }
     
     public func mapView(_ mapView: MKMapView, didAdd renderers: [MKOverlayRenderer]) {
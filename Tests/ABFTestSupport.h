@@ -0,0 +1,189 @@
+//
+//  ABFTestSupport.h
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#ifndef ABFTestSupport_h
+#define ABFTestSupport_h
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ *  Number of failed checks in the running test executable
+ */
+static int ABFTestFailureCount = 0;
+
+#define ABF_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ABFTestFailureCount++; \
+        } \
+    } while (0)
+
+/**
+ *  Deterministic xorshift generator, so test inputs are identical on every platform
+ */
+class ABFTestRandom {
+public:
+    explicit ABFTestRandom(uint64_t seed) : state(seed ? seed : 1) {}
+    
+    uint64_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    
+    /**
+     *  Uniform value in [minimum, maximum)
+     */
+    double uniform(double minimum, double maximum)
+    {
+        return minimum + (next() >> 11) * (1.0 / 9007199254740992.0) * (maximum - minimum);
+    }
+    
+    /**
+     *  Roughly normal value from the sum of uniform values
+     */
+    double normal(double mean, double deviation)
+    {
+        double sum = 0;
+        
+        for (int i = 0; i < 12; i++) {
+            sum += uniform(0, 1);
+        }
+        
+        return mean + (sum - 6) * deviation;
+    }
+
+private:
+    uint64_t state;
+};
+
+/**
+ *  Monotonic time in seconds
+ */
+static inline double ABFTestSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ *  Width of the world in map points (MKMapSizeWorld)
+ */
+static const double ABFTestMapSizeWorld = 268435456.0;
+
+/**
+ *  Spherical Mercator projection of a coordinate, the same as MKMapPointForCoordinate
+ */
+static inline void ABFTestMapPointForCoordinate(double latitude,
+                                                double longitude,
+                                                double &x,
+                                                double &y)
+{
+    double latitudeRadians = latitude * M_PI / 180.0;
+    
+    x = (longitude + 180.0) / 360.0 * ABFTestMapSizeWorld;
+    y = (0.5 - std::log(std::tan(M_PI / 4.0 + latitudeRadians / 2.0)) / (2.0 * M_PI)) * ABFTestMapSizeWorld;
+}
+
+/**
+ *  Reads the RGBA pixels of a PAM image written by ABFTestWritePAM
+ */
+static inline bool ABFTestReadPAM(const std::string &path,
+                                  uint32_t &width,
+                                  uint32_t &height,
+                                  std::vector<uint32_t> &pixels)
+{
+    FILE *file = std::fopen(path.c_str(), "rb");
+    
+    if (!file) {
+        return false;
+    }
+    
+    unsigned int fileWidth = 0, fileHeight = 0;
+    
+    bool valid = (std::fscanf(file, "P7\nWIDTH %u\nHEIGHT %u\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR", &fileWidth, &fileHeight) == 2 &&
+                  std::fgetc(file) == '\n');
+    
+    if (valid) {
+        width = fileWidth;
+        height = fileHeight;
+        pixels.resize((size_t)width * height);
+        
+        valid = std::fread(pixels.data(), sizeof(uint32_t), pixels.size(), file) == pixels.size();
+    }
+    
+    std::fclose(file);
+    
+    return valid;
+}
+
+/**
+ *  Writes RGBA pixels as a PAM image, a header followed by the raw bytes
+ */
+static inline bool ABFTestWritePAM(const std::string &path,
+                                   uint32_t width,
+                                   uint32_t height,
+                                   const std::vector<uint32_t> &pixels)
+{
+    FILE *file = std::fopen(path.c_str(), "wb");
+    
+    if (!file) {
+        return false;
+    }
+    
+    std::fprintf(file, "P7\nWIDTH %u\nHEIGHT %u\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", width, height);
+    
+    bool written = std::fwrite(pixels.data(), sizeof(uint32_t), pixels.size(), file) == pixels.size();
+    
+    std::fclose(file);
+    
+    return written;
+}
+
+/**
+ *  Largest difference between the channels of two images of the same size
+ */
+static inline int ABFTestMaxChannelDifference(const std::vector<uint32_t> &a,
+                                              const std::vector<uint32_t> &b)
+{
+    const uint8_t *aBytes = (const uint8_t *)a.data();
+    const uint8_t *bBytes = (const uint8_t *)b.data();
+    
+    int difference = 0;
+    
+    for (size_t i = 0; i < a.size() * 4; i++) {
+        difference = std::max(difference, std::abs((int)aBytes[i] - (int)bBytes[i]));
+    }
+    
+    return difference;
+}
+
+/**
+ *  Exit status of a test executable
+ */
+static inline int ABFTestFinish(const char *name)
+{
+    if (ABFTestFailureCount > 0) {
+        std::fprintf(stderr, "%s: %d check(s) failed\n", name, ABFTestFailureCount);
+        return EXIT_FAILURE;
+    }
+    
+    std::printf("%s: passed\n", name);
+    return EXIT_SUCCESS;
+}
+
+#endif /* ABFTestSupport_h */
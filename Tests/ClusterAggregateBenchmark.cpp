@@ -0,0 +1,162 @@
+//
+//  ClusterAggregateBenchmark.cpp
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#include "ABFClusterAggregate.h"
+#include "ABFTestSupport.h"
+
+/**
+ *  World-scale stress test of the aggregate-only clustering: millions of objects spread over the world, clustered at the zoom levels where the map shows all or most of them.
+ *
+ *  Usage: ClusterAggregateBenchmark [object count] [passes per zoom level]
+ */
+
+struct ABFBenchmarkZoom {
+    const char *name;
+    
+    /**
+     *  Width of the visible map rect in map points
+     */
+    double visibleWidth;
+};
+
+/**
+ *  Objects in cities (clusters of about 50 km) plus a uniform background between 60°S and 70°N
+ */
+static void ABFBenchmarkWorldObjects(size_t count,
+                                     std::vector<double> &latitudes,
+                                     std::vector<double> &longitudes)
+{
+    ABFTestRandom random(5);
+    
+    const size_t cityCount = 500;
+    
+    std::vector<double> cityLatitudes(cityCount);
+    std::vector<double> cityLongitudes(cityCount);
+    
+    for (size_t i = 0; i < cityCount; i++) {
+        cityLatitudes[i] = random.uniform(-45, 60);
+        cityLongitudes[i] = random.uniform(-180, 180);
+    }
+    
+    latitudes.resize(count);
+    longitudes.resize(count);
+    
+    for (size_t i = 0; i < count; i++) {
+        if (i % 5 < 3) {
+            size_t city = random.next() % cityCount;
+            
+            latitudes[i] = std::max(-85.0, std::min(85.0, random.normal(cityLatitudes[city], 0.25)));
+            longitudes[i] = random.normal(cityLongitudes[city], 0.25);
+            
+            // Wrap across the -180/180 meridian
+            if (longitudes[i] < -180) {
+                longitudes[i] += 360;
+            }
+            else if (longitudes[i] >= 180) {
+                longitudes[i] -= 360;
+            }
+        }
+        else {
+            latitudes[i] = random.uniform(-60, 70);
+            longitudes[i] = random.uniform(-180, 180);
+        }
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    size_t count = argc > 1 ? (size_t)std::atol(argv[1]) : 5000000;
+    int passes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+    
+    std::vector<double> latitudes;
+    std::vector<double> longitudes;
+    
+    ABFBenchmarkWorldObjects(count, latitudes, longitudes);
+    
+    std::printf("%zu objects, %d pass(es) per zoom level\n", count, passes);
+    
+    // An iPhone in portrait (375 points across) with the default 88 pixel cluster cells
+    const double viewWidth = 375;
+    const double clusterSize = 88;
+    
+    const ABFBenchmarkZoom zooms[] = {
+        {"world", ABFTestMapSizeWorld},
+        {"continent", ABFTestMapSizeWorld / 8},
+        {"country", ABFTestMapSizeWorld / 64},
+    };
+    
+    for (const ABFBenchmarkZoom &zoom : zooms) {
+        double scaleFactor = (viewWidth / zoom.visibleWidth) / clusterSize;
+        
+        double best = 0;
+        size_t cellCount = 0;
+        size_t capacity = 0;
+        
+        for (int pass = 0; pass < passes; pass++) {
+            ABFClusterAggregateTable table;
+            
+            double start = ABFTestSeconds();
+            
+            bool initialized = ABFClusterAggregateTableInit(&table, 1024);
+            
+            ABF_CHECK(initialized);
+            
+            if (!initialized) {
+                return ABFTestFinish("ClusterAggregateBenchmark");
+            }
+            
+            bool added = true;
+            
+            // The whole dataset, as the controller does for a region that contains every object
+            for (size_t i = 0; i < count && added; i++) {
+                double x, y;
+                ABFTestMapPointForCoordinate(latitudes[i], longitudes[i], x, y);
+                
+                added = ABFClusterAggregateAdd(&table, ABFClusterAggregateKey(x, y, scaleFactor), i, 0, latitudes[i], longitudes[i]);
+            }
+            
+            double elapsed = ABFTestSeconds() - start;
+            
+            ABF_CHECK(added);
+            
+            size_t total = 0;
+            size_t occupied = 0;
+            
+            for (size_t slot = 0; slot < table.capacity; slot++) {
+                total += table.cells[slot].count;
+                occupied += table.cells[slot].count > 0;
+            }
+            
+            // Every object is counted once and the table stays at most half full
+            ABF_CHECK(total == count);
+            ABF_CHECK(occupied == table.cellCount);
+            ABF_CHECK(table.cellCount * 2 <= table.capacity);
+            
+            if (pass == 0 || elapsed < best) {
+                best = elapsed;
+            }
+            
+            cellCount = table.cellCount;
+            capacity = table.capacity;
+            
+            ABFClusterAggregateTableFree(&table);
+        }
+        
+        double tableBytes = (double)capacity * sizeof(ABFClusterAggregate);
+        
+        std::printf("%-10s %8zu cells: %7.1f ms, %6.1f M objects/s, table %7.2f MB (%.2f bytes per object)\n",
+                    zoom.name,
+                    cellCount,
+                    best * 1000,
+                    count / best / 1e6,
+                    tableBytes / (1 << 20),
+                    tableBytes / count);
+    }
+    
+    return ABFTestFinish("ClusterAggregateBenchmark");
+}
@@ -0,0 +1,224 @@
+//
+//  ClusterAggregateTests.cpp
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#include "ABFClusterAggregate.h"
+#include "ABFTestSupport.h"
+
+#include <map>
+
+struct ABFTestCell {
+    size_t count = 0;
+    size_t index = 0;
+    double totalLatitude = 0;
+    double totalLongitude = 0;
+};
+
+static bool ABFTestIsPowerOfTwo(size_t value)
+{
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+static void ABFTestKeys()
+{
+    // 64 map points per cell
+    double scaleFactor = 1.0 / 64;
+    
+    ABF_CHECK(ABFClusterAggregateKey(0, 0, scaleFactor) == 0);
+    ABF_CHECK(ABFClusterAggregateKey(63.9, 63.9, scaleFactor) == 0);
+    ABF_CHECK(ABFClusterAggregateKey(64, 0, scaleFactor) == (1ULL << 32));
+    ABF_CHECK(ABFClusterAggregateKey(0, 64, scaleFactor) == 1);
+    
+    // The far corner of the world at the closest zoom still fits the 32 bits of a row or column
+    uint64_t key = ABFClusterAggregateKey(ABFTestMapSizeWorld - 1, ABFTestMapSizeWorld - 1, 1.0);
+    
+    ABF_CHECK((key >> 32) == (uint64_t)ABFTestMapSizeWorld - 1);
+    ABF_CHECK((key & 0xFFFFFFFF) == (uint64_t)ABFTestMapSizeWorld - 1);
+}
+
+static void ABFTestGrowKeepsCells()
+{
+    ABFClusterAggregateTable table;
+    
+    ABF_CHECK(ABFClusterAggregateTableInit(&table, 10));
+    ABF_CHECK(table.capacity == 16);
+    
+    const size_t cellCount = 10000;
+    
+    for (size_t i = 0; i < cellCount; i++) {
+        // Two objects per cell, added in separate passes
+        ABF_CHECK(ABFClusterAggregateAdd(&table, i * 7919, i, 0, 1, 2));
+    }
+    
+    for (size_t i = 0; i < cellCount; i++) {
+        ABF_CHECK(ABFClusterAggregateAdd(&table, i * 7919, cellCount + i, 0, 3, 4));
+    }
+    
+    ABF_CHECK(table.cellCount == cellCount);
+    ABF_CHECK(ABFTestIsPowerOfTwo(table.capacity));
+    ABF_CHECK(table.cellCount * 2 <= table.capacity);
+    
+    size_t occupied = 0;
+    
+    for (size_t slot = 0; slot < table.capacity; slot++) {
+        occupied += table.cells[slot].count > 0;
+    }
+    
+    ABF_CHECK(occupied == cellCount);
+    
+    for (size_t i = 0; i < cellCount; i++) {
+        ABFClusterAggregate *aggregate = ABFClusterAggregateSlot(&table, i * 7919);
+        
+        ABF_CHECK(aggregate->key == i * 7919);
+        ABF_CHECK(aggregate->count == 2);
+        ABF_CHECK(aggregate->index == i);
+        ABF_CHECK(aggregate->totalLatitude == 4 && aggregate->totalLongitude == 6);
+    }
+    
+    // Missing keys land on an empty slot
+    ABF_CHECK(ABFClusterAggregateSlot(&table, 1)->count == 0);
+    
+    ABFClusterAggregateTableFree(&table);
+    
+    ABF_CHECK(table.cells == nullptr && table.capacity == 0 && table.cellCount == 0);
+    
+    // Freeing twice is harmless
+    ABFClusterAggregateTableFree(&table);
+}
+
+static void ABFTestMatchesReference()
+{
+    ABFTestRandom random(31);
+    
+    // A regional view: cells about 88 pixels across at zoom 6
+    double scaleFactor = (256.0 * 64 / ABFTestMapSizeWorld) / 88;
+    
+    ABFClusterAggregateTable table;
+    ABF_CHECK(ABFClusterAggregateTableInit(&table, 1024));
+    
+    std::map<uint64_t, ABFTestCell> reference;
+    
+    const size_t count = 50000;
+    
+    for (size_t i = 0; i < count; i++) {
+        double latitude = random.normal(40, 4);
+        double longitude = random.normal(-100, 8);
+        
+        double x, y;
+        ABFTestMapPointForCoordinate(latitude, longitude, x, y);
+        
+        uint64_t key = ABFClusterAggregateKey(x, y, scaleFactor);
+        
+        ABF_CHECK(ABFClusterAggregateAdd(&table, key, i, 0, latitude, longitude));
+        
+        ABFTestCell &cell = reference[key];
+        
+        if (cell.count == 0) {
+            cell.index = i;
+        }
+        
+        cell.count++;
+        cell.totalLatitude += latitude;
+        cell.totalLongitude += longitude;
+    }
+    
+    ABF_CHECK(table.cellCount == reference.size());
+    
+    size_t total = 0;
+    
+    for (const auto &entry : reference) {
+        ABFClusterAggregate *aggregate = ABFClusterAggregateSlot(&table, entry.first);
+        
+        // Same objects in the same order, so the totals are identical
+        ABF_CHECK(aggregate->count == entry.second.count);
+        ABF_CHECK(aggregate->index == entry.second.index);
+        ABF_CHECK(aggregate->totalLatitude == entry.second.totalLatitude);
+        ABF_CHECK(aggregate->totalLongitude == entry.second.totalLongitude);
+        
+        total += aggregate->count;
+    }
+    
+    ABF_CHECK(total == count);
+    
+    ABFClusterAggregateTableFree(&table);
+}
+
+static void ABFTestMergeLayers()
+{
+    ABFTestRandom random(32);
+    
+    double scaleFactor = 1.0 / 4096;
+    
+    ABFClusterAggregateTable layers[2];
+    ABFClusterAggregateTable combined;
+    
+    ABF_CHECK(ABFClusterAggregateTableInit(&layers[0], 16));
+    ABF_CHECK(ABFClusterAggregateTableInit(&layers[1], 16));
+    ABF_CHECK(ABFClusterAggregateTableInit(&combined, 16));
+    
+    for (size_t i = 0; i < 20000; i++) {
+        size_t layer = i % 2;
+        
+        double x = random.uniform(0, 1 << 20);
+        double y = random.uniform(0, 1 << 20);
+        
+        uint64_t key = ABFClusterAggregateKey(x, y, scaleFactor);
+        
+        ABF_CHECK(ABFClusterAggregateAdd(&layers[layer], key, i / 2, layer, 1, 1));
+        ABF_CHECK(ABFClusterAggregateAdd(&combined, key, i, layer, 1, 1));
+    }
+    
+    // Sized for every layer cell, as the controller does, so the slots of merged cells don't move
+    ABFClusterAggregateTable merged;
+    ABF_CHECK(ABFClusterAggregateTableInit(&merged, (layers[0].cellCount + layers[1].cellCount) * 2));
+    
+    size_t capacity = merged.capacity;
+    
+    for (size_t layer = 0; layer < 2; layer++) {
+        for (size_t slot = 0; slot < layers[layer].capacity; slot++) {
+            if (layers[layer].cells[slot].count > 0) {
+                ABF_CHECK(ABFClusterAggregateMerge(&merged, &layers[layer].cells[slot]) != nullptr);
+            }
+        }
+    }
+    
+    ABF_CHECK(merged.capacity == capacity);
+    ABF_CHECK(merged.cellCount == combined.cellCount);
+    
+    for (size_t slot = 0; slot < combined.capacity; slot++) {
+        const ABFClusterAggregate &expected = combined.cells[slot];
+        
+        if (expected.count == 0) {
+            continue;
+        }
+        
+        ABFClusterAggregate *aggregate = ABFClusterAggregateSlot(&merged, expected.key);
+        
+        ABF_CHECK(aggregate->count == expected.count);
+        ABF_CHECK(aggregate->totalLatitude == expected.totalLatitude);
+        
+        // A cell keeps the first layer merged into it
+        ABFClusterAggregate *firstLayer = ABFClusterAggregateSlot(&layers[0], expected.key);
+        
+        ABF_CHECK(aggregate->layer == (firstLayer->count > 0 ? 0u : 1u));
+    }
+    
+    ABFClusterAggregateTableFree(&layers[0]);
+    ABFClusterAggregateTableFree(&layers[1]);
+    ABFClusterAggregateTableFree(&combined);
+    ABFClusterAggregateTableFree(&merged);
+}
+
+int main()
+{
+    ABFTestKeys();
+    ABFTestGrowKeepsCells();
+    ABFTestMatchesReference();
+    ABFTestMergeLayers();
+    
+    return ABFTestFinish("ClusterAggregateTests");
+}
@@ -0,0 +1,301 @@
+//
+//  GeometryKernelsBenchmark.cpp
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#include "ABFGeometryKernels.h"
+#include "ABFTestSupport.h"
+
+#include <cstring>
+#include <functional>
+
+/**
+ *  Throughput of the batched circle and polygon kernels against the predicate path they replace: the bounding box fetched with NSPredicateForCoordinateRegion, then every object evaluated on its own.
+ *
+ *  NSPredicate is not available without Foundation, so the predicate path is modeled by a type-erased block per object that reads the coordinate by key path, as evaluateWithObject: does through key-value coding, and tests the object with branching scalar code.
+ *
+ *  Usage: GeometryKernelsBenchmark [object count] [passes]
+ */
+
+static const double ABFBenchmarkEarthRadius = 6371008.8;
+
+struct ABFBenchmarkObject {
+    double latitude;
+    double longitude;
+};
+
+/**
+ *  Key-value coding stand-in: the value for a key path looked up by name
+ */
+static double ABFBenchmarkValueForKeyPath(const ABFBenchmarkObject &object,
+                                          const char *keyPath)
+{
+    if (std::strcmp(keyPath, "latitude") == 0) {
+        return object.latitude;
+    }
+    else if (std::strcmp(keyPath, "longitude") == 0) {
+        return object.longitude;
+    }
+    
+    return NAN;
+}
+
+typedef std::function<bool(const ABFBenchmarkObject &)> ABFBenchmarkPredicate;
+
+/**
+ *  The bounding box predicate of NSPredicateForCoordinateRegion, with strict bounds
+ */
+static ABFBenchmarkPredicate ABFBenchmarkRegionPredicate(double minLatitude,
+                                                         double maxLatitude,
+                                                         double minLongitude,
+                                                         double maxLongitude)
+{
+    return [=](const ABFBenchmarkObject &object) {
+        double latitude = ABFBenchmarkValueForKeyPath(object, "latitude");
+        double longitude = ABFBenchmarkValueForKeyPath(object, "longitude");
+        
+        return (latitude < maxLatitude && latitude > minLatitude &&
+                longitude < maxLongitude && longitude > minLongitude);
+    };
+}
+
+/**
+ *  Per-object distance test, as a block comparing the distance between locations with the radius
+ */
+static ABFBenchmarkPredicate ABFBenchmarkCirclePredicate(ABFGeoPoint center,
+                                                         double radius)
+{
+    return [=](const ABFBenchmarkObject &object) {
+        double radians = M_PI / 180;
+        
+        double latitude = ABFBenchmarkValueForKeyPath(object, "latitude");
+        double longitude = ABFBenchmarkValueForKeyPath(object, "longitude");
+        
+        double sinHalfLatitude = std::sin((latitude - center.latitude) * radians / 2);
+        double sinHalfLongitude = std::sin((longitude - center.longitude) * radians / 2);
+        
+        double haversine = (sinHalfLatitude * sinHalfLatitude +
+                            std::cos(center.latitude * radians) * std::cos(latitude * radians) * sinHalfLongitude * sinHalfLongitude);
+        
+        double distance = 2 * std::atan2(std::sqrt(haversine), std::sqrt(1 - haversine)) * ABFBenchmarkEarthRadius;
+        
+        return distance <= radius;
+    };
+}
+
+/**
+ *  Per-object even-odd test with an early branch per edge
+ */
+static ABFBenchmarkPredicate ABFBenchmarkPolygonPredicate(const std::vector<ABFGeoPoint> &vertices)
+{
+    return [=](const ABFBenchmarkObject &object) {
+        double latitude = ABFBenchmarkValueForKeyPath(object, "latitude");
+        double longitude = ABFBenchmarkValueForKeyPath(object, "longitude");
+        
+        bool inside = false;
+        
+        for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+            if ((vertices[i].latitude > latitude) == (vertices[j].latitude > latitude)) {
+                continue;
+            }
+            
+            double crossing = (vertices[i].longitude + (latitude - vertices[i].latitude) *
+                               (vertices[j].longitude - vertices[i].longitude) / (vertices[j].latitude - vertices[i].latitude));
+            
+            if (longitude < crossing) {
+                inside = !inside;
+            }
+        }
+        
+        return inside;
+    };
+}
+
+/**
+ *  Fetches the bounding box, then evaluates each fetched object with the predicate
+ */
+static size_t ABFBenchmarkPredicatePath(const std::vector<ABFBenchmarkObject> &objects,
+                                        const ABFBenchmarkPredicate &region,
+                                        const ABFBenchmarkPredicate &predicate)
+{
+    size_t count = 0;
+    
+    for (const ABFBenchmarkObject &object : objects) {
+        if (region(object) && predicate(object)) {
+            count++;
+        }
+    }
+    
+    return count;
+}
+
+/**
+ *  Fetches the bounding box, then evaluates the fetched coordinates in batches with a kernel, as ABFLocationFetchedResultsController does
+ */
+template <typename Kernel>
+static size_t ABFBenchmarkKernelPath(const std::vector<ABFBenchmarkObject> &objects,
+                                     const ABFBenchmarkPredicate &region,
+                                     Kernel kernel)
+{
+    const size_t batchSize = 256;
+    
+    ABFGeoPoint coordinates[batchSize];
+    uint8_t included[batchSize];
+    
+    size_t batchCount = 0;
+    size_t count = 0;
+    
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (region(objects[i])) {
+            coordinates[batchCount].latitude = objects[i].latitude;
+            coordinates[batchCount].longitude = objects[i].longitude;
+            batchCount++;
+        }
+        
+        if (batchCount < batchSize &&
+            i + 1 < objects.size()) {
+            continue;
+        }
+        
+        kernel(coordinates, batchCount, included);
+        
+        for (size_t j = 0; j < batchCount; j++) {
+            count += included[j];
+        }
+        
+        batchCount = 0;
+    }
+    
+    return count;
+}
+
+template <typename Path>
+static double ABFBenchmarkBestSeconds(int passes,
+                                      size_t &count,
+                                      Path path)
+{
+    double best = 0;
+    
+    for (int pass = 0; pass < passes; pass++) {
+        double start = ABFTestSeconds();
+        
+        count = path();
+        
+        double elapsed = ABFTestSeconds() - start;
+        
+        if (pass == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    
+    return best;
+}
+
+static void ABFBenchmarkReport(const char *name,
+                               size_t fetchedCount,
+                               size_t includedCount,
+                               double predicateSeconds,
+                               double kernelSeconds)
+{
+    std::printf("%-8s %8zu fetched, %8zu included: predicate %7.1f ms, kernel %7.1f ms (%.1fx)\n",
+                name,
+                fetchedCount,
+                includedCount,
+                predicateSeconds * 1000,
+                kernelSeconds * 1000,
+                predicateSeconds / kernelSeconds);
+}
+
+int main(int argc, const char *argv[])
+{
+    size_t count = argc > 1 ? (size_t)std::atol(argv[1]) : 2000000;
+    int passes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+    
+    ABFTestRandom random(43);
+    
+    // Objects concentrated over a region around the shapes, so most of them are in the fetched bounding boxes
+    std::vector<ABFBenchmarkObject> objects(count);
+    
+    for (ABFBenchmarkObject &object : objects) {
+        object.latitude = random.uniform(30, 50);
+        object.longitude = random.uniform(-110, -90);
+    }
+    
+    std::printf("%zu objects, %d pass(es)\n", count, passes);
+    
+    // A 500 km circle
+    ABFGeoPoint center = {40, -100};
+    double radius = 500000;
+    
+    double latitudeRadius = radius / ABFBenchmarkEarthRadius * 180 / M_PI;
+    double longitudeRadius = latitudeRadius / std::cos((center.latitude + latitudeRadius) * M_PI / 180);
+    
+    ABFBenchmarkPredicate circleRegion = ABFBenchmarkRegionPredicate(center.latitude - latitudeRadius,
+                                                                     center.latitude + latitudeRadius,
+                                                                     center.longitude - longitudeRadius,
+                                                                     center.longitude + longitudeRadius);
+    
+    ABFBenchmarkPredicate circlePredicate = ABFBenchmarkCirclePredicate(center, radius);
+    
+    size_t fetchedCount = 0;
+    size_t predicateCount = 0;
+    size_t kernelCount = 0;
+    
+    ABFBenchmarkBestSeconds(1, fetchedCount, [&] {
+        return ABFBenchmarkPredicatePath(objects, circleRegion, [](const ABFBenchmarkObject &) { return true; });
+    });
+    
+    double predicateSeconds = ABFBenchmarkBestSeconds(passes, predicateCount, [&] {
+        return ABFBenchmarkPredicatePath(objects, circleRegion, circlePredicate);
+    });
+    
+    double kernelSeconds = ABFBenchmarkBestSeconds(passes, kernelCount, [&] {
+        return ABFBenchmarkKernelPath(objects, circleRegion, [&](const ABFGeoPoint *coordinates, size_t batchCount, uint8_t *included) {
+            ABFGeoCircleContainsPoints(center, radius / ABFBenchmarkEarthRadius, coordinates, batchCount, included);
+        });
+    });
+    
+    ABF_CHECK(predicateCount == kernelCount);
+    ABF_CHECK(kernelCount > 0 && kernelCount < fetchedCount);
+    
+    ABFBenchmarkReport("circle", fetchedCount, kernelCount, predicateSeconds, kernelSeconds);
+    
+    // A 64 vertex star
+    std::vector<ABFGeoPoint> vertices;
+    
+    for (int i = 0; i < 64; i++) {
+        double angle = i * 2 * M_PI / 64;
+        double starRadius = i % 2 ? 8 : 4;
+        
+        vertices.push_back({40 + starRadius * std::sin(angle), -100 + starRadius * std::cos(angle)});
+    }
+    
+    size_t ringCounts[] = {vertices.size()};
+    
+    ABFBenchmarkPredicate polygonRegion = ABFBenchmarkRegionPredicate(32, 48, -108, -92);
+    ABFBenchmarkPredicate polygonPredicate = ABFBenchmarkPolygonPredicate(vertices);
+    
+    ABFBenchmarkBestSeconds(1, fetchedCount, [&] {
+        return ABFBenchmarkPredicatePath(objects, polygonRegion, [](const ABFBenchmarkObject &) { return true; });
+    });
+    
+    predicateSeconds = ABFBenchmarkBestSeconds(passes, predicateCount, [&] {
+        return ABFBenchmarkPredicatePath(objects, polygonRegion, polygonPredicate);
+    });
+    
+    kernelSeconds = ABFBenchmarkBestSeconds(passes, kernelCount, [&] {
+        return ABFBenchmarkKernelPath(objects, polygonRegion, [&](const ABFGeoPoint *coordinates, size_t batchCount, uint8_t *included) {
+            ABFGeoPolygonContainsPoints(vertices.data(), ringCounts, 1, coordinates, batchCount, included);
+        });
+    });
+    
+    ABF_CHECK(predicateCount == kernelCount);
+    ABF_CHECK(kernelCount > 0 && kernelCount < fetchedCount);
+    
+    ABFBenchmarkReport("polygon", fetchedCount, kernelCount, predicateSeconds, kernelSeconds);
+    
+    return ABFTestFinish("GeometryKernelsBenchmark");
+}
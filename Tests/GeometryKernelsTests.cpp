@@ -0,0 +1,561 @@
+//
+//  GeometryKernelsTests.cpp
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#include "ABFGeometryKernels.h"
+#include "ABFTestSupport.h"
+
+/**
+ *  Mean radius of the Earth in meters, as ABFEarthRadius
+ */
+static const double ABFTestEarthRadius = 6371008.8;
+
+/**
+ *  Great-circle distance in radians with the atan2 form of the haversine formula, accurate at every distance
+ */
+static double ABFTestAngularDistance(ABFGeoPoint a,
+                                     ABFGeoPoint b)
+{
+    double radians = M_PI / 180;
+    
+    double sinHalfLatitude = std::sin((b.latitude - a.latitude) * radians / 2);
+    double sinHalfLongitude = std::sin((b.longitude - a.longitude) * radians / 2);
+    
+    double haversine = (sinHalfLatitude * sinHalfLatitude +
+                        std::cos(a.latitude * radians) * std::cos(b.latitude * radians) * sinHalfLongitude * sinHalfLongitude);
+    
+    return 2 * std::atan2(std::sqrt(haversine), std::sqrt(std::max(0.0, 1 - haversine)));
+}
+
+/**
+ *  PNPOLY even-odd test of a single ring, with the point already in the longitude frame of the ring
+ */
+static bool ABFTestRingContains(const std::vector<ABFGeoPoint> &ring,
+                                ABFGeoPoint point)
+{
+    bool inside = false;
+    
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        if ((ring[i].latitude > point.latitude) != (ring[j].latitude > point.latitude) &&
+            point.longitude < (ring[j].longitude - ring[i].longitude) * (point.latitude - ring[i].latitude) / (ring[j].latitude - ring[i].latitude) + ring[i].longitude) {
+            inside = !inside;
+        }
+    }
+    
+    return inside;
+}
+
+/**
+ *  Whether the predicate of NSPredicateForCoordinateRegions for a covering region matches a stored coordinate: strict bounds, regions past the -180/180 meridian split in two plus the meridian itself, and regions 360 degrees wide match every longitude
+ */
+static bool ABFTestRegionContains(const ABFGeoRegion &region,
+                                  ABFGeoPoint point)
+{
+    double minLatitude = region.center.latitude - region.latitudeDelta / 2;
+    double maxLatitude = region.center.latitude + region.latitudeDelta / 2;
+    
+    if (!(point.latitude < maxLatitude && point.latitude > minLatitude)) {
+        return false;
+    }
+    
+    if (region.longitudeDelta >= 360) {
+        return true;
+    }
+    
+    double minLongitude = region.center.longitude - region.longitudeDelta / 2;
+    double maxLongitude = region.center.longitude + region.longitudeDelta / 2;
+    
+    bool onMeridian = point.longitude == 180 || point.longitude == -180;
+    
+    if (maxLongitude > 180) {
+        return (onMeridian ||
+                (point.longitude < 180 && point.longitude > minLongitude) ||
+                (point.longitude < maxLongitude - 360 && point.longitude > -180));
+    }
+    else if (minLongitude < -180) {
+        return (onMeridian ||
+                (point.longitude < 180 && point.longitude > minLongitude + 360) ||
+                (point.longitude < maxLongitude && point.longitude > -180));
+    }
+    
+    return point.longitude < maxLongitude && point.longitude > minLongitude;
+}
+
+/**
+ *  Counts the points a kernel included that no covering region contains, so the coarse fetch would have dropped them
+ */
+static size_t ABFTestUncoveredCount(const std::vector<ABFGeoRegion> &regions,
+                                    const std::vector<ABFGeoPoint> &points,
+                                    const std::vector<uint8_t> &results)
+{
+    size_t uncoveredCount = 0;
+    
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!results[i]) {
+            continue;
+        }
+        
+        bool covered = false;
+        
+        for (const ABFGeoRegion &region : regions) {
+            covered = covered || ABFTestRegionContains(region, points[i]);
+        }
+        
+        uncoveredCount += !covered;
+    }
+    
+    return uncoveredCount;
+}
+
+/**
+ *  Point at an angular distance and bearing from a start point, with the longitude normalized as it is stored
+ */
+static ABFGeoPoint ABFTestDestination(ABFGeoPoint start,
+                                      double angularDistance,
+                                      double bearing)
+{
+    double radians = M_PI / 180;
+    
+    double latitude = start.latitude * radians;
+    
+    double destinationLatitude = std::asin(std::sin(latitude) * std::cos(angularDistance) +
+                                           std::cos(latitude) * std::sin(angularDistance) * std::cos(bearing));
+    
+    double longitudeDelta = std::atan2(std::sin(bearing) * std::sin(angularDistance) * std::cos(latitude),
+                                       std::cos(angularDistance) - std::sin(latitude) * std::sin(destinationLatitude));
+    
+    ABFGeoPoint destination = {destinationLatitude / radians, ABFGeoNormalizedLongitude(start.longitude + longitudeDelta / radians)};
+    
+    return destination;
+}
+
+static std::vector<ABFGeoPoint> ABFTestRandomPoints(ABFTestRandom &random,
+                                                    size_t count,
+                                                    double minLatitude,
+                                                    double maxLatitude,
+                                                    double minLongitude,
+                                                    double maxLongitude)
+{
+    std::vector<ABFGeoPoint> points(count);
+    
+    for (ABFGeoPoint &point : points) {
+        point.latitude = random.uniform(minLatitude, maxLatitude);
+        point.longitude = random.uniform(minLongitude, maxLongitude);
+    }
+    
+    return points;
+}
+
+static void ABFTestNormalizedLongitude()
+{
+    ABF_CHECK(ABFGeoNormalizedLongitude(0) == 0);
+    ABF_CHECK(ABFGeoNormalizedLongitude(180) == -180);
+    ABF_CHECK(ABFGeoNormalizedLongitude(-180) == -180);
+    ABF_CHECK(ABFGeoNormalizedLongitude(190) == -170);
+    ABF_CHECK(ABFGeoNormalizedLongitude(-190) == 170);
+    ABF_CHECK(ABFGeoNormalizedLongitude(725) == 5);
+}
+
+static void ABFTestUnwrap()
+{
+    // A ring across the -180/180 meridian becomes continuous, the first vertex follows the reference
+    ABFGeoPoint points[] = {{0, 170}, {0, -175}, {10, -170}, {10, 175}};
+    
+    ABFGeoUnwrapLongitudes(points, 4, 180);
+    
+    ABF_CHECK(points[0].longitude == 170);
+    ABF_CHECK(points[1].longitude == 185);
+    ABF_CHECK(points[2].longitude == 190);
+    ABF_CHECK(points[3].longitude == 175);
+    
+    // Latitudes are unchanged
+    ABF_CHECK(points[2].latitude == 10);
+}
+
+static void ABFTestCircleBoundary()
+{
+    ABFGeoPoint center = {40, -100};
+    
+    double radius = 100000;
+    double angularRadius = radius / ABFTestEarthRadius;
+    
+    // Points due north just inside and just outside the radius (about 1 m)
+    double degrees = angularRadius * 180 / M_PI;
+    double epsilon = 1.0 / ABFTestEarthRadius * 180 / M_PI;
+    
+    ABFGeoPoint points[] = {
+        center,
+        {center.latitude + degrees - epsilon, center.longitude},
+        {center.latitude + degrees + epsilon, center.longitude},
+        {center.latitude - degrees + epsilon, center.longitude},
+        {center.latitude - degrees - epsilon, center.longitude},
+    };
+    
+    uint8_t results[5];
+    
+    ABFGeoCircleContainsPoints(center, angularRadius, points, 5, results);
+    
+    ABF_CHECK(results[0] == 1);
+    ABF_CHECK(results[1] == 1);
+    ABF_CHECK(results[2] == 0);
+    ABF_CHECK(results[3] == 1);
+    ABF_CHECK(results[4] == 0);
+    
+    // A radius of 0 only contains the center
+    ABFGeoCircleContainsPoints(center, 0, points, 2, results);
+    
+    ABF_CHECK(results[0] == 1);
+    ABF_CHECK(results[1] == 0);
+    
+    // Half the circumference contains the whole sphere
+    ABFGeoPoint antipode = {-40, 80};
+    
+    ABFGeoCircleContainsPoints(center, M_PI, &antipode, 1, results);
+    
+    ABF_CHECK(results[0] == 1);
+}
+
+static void ABFTestCircleAcrossMeridianAndPole()
+{
+    uint8_t results[3];
+    
+    // Centered on the -180/180 meridian, points on both sides are inside
+    ABFGeoPoint meridianCenter = {0, 180};
+    ABFGeoPoint meridianPoints[] = {{0, 179.5}, {0, -179.5}, {0, 178}};
+    
+    ABFGeoCircleContainsPoints(meridianCenter, 100000 / ABFTestEarthRadius, meridianPoints, 3, results);
+    
+    ABF_CHECK(results[0] == 1);
+    ABF_CHECK(results[1] == 1);
+    ABF_CHECK(results[2] == 0);
+    
+    // Around the pole every longitude at a high enough latitude is inside
+    ABFGeoPoint poleCenter = {90, 0};
+    ABFGeoPoint polePoints[] = {{89.5, 0}, {89.5, 179}, {88, -90}};
+    
+    ABFGeoCircleContainsPoints(poleCenter, 100000 / ABFTestEarthRadius, polePoints, 3, results);
+    
+    ABF_CHECK(results[0] == 1);
+    ABF_CHECK(results[1] == 1);
+    ABF_CHECK(results[2] == 0);
+}
+
+static void ABFTestCircleMatchesReference()
+{
+    ABFTestRandom random(41);
+    
+    const double radii[] = {500, 50000, 2000000, 15000000};
+    
+    // Counts that end inside a batch and exactly on batch boundaries
+    const size_t counts[] = {1, 255, 256, 257, 513, 20000};
+    
+    for (double radius : radii) {
+        for (size_t count : counts) {
+            ABFGeoPoint center = {random.uniform(-80, 80), random.uniform(-180, 180)};
+            
+            double angularRadius = radius / ABFTestEarthRadius;
+            
+            // Points around the center, about half of them inside the radius
+            double spread = std::min(90.0, angularRadius * 180 / M_PI * 1.5);
+            
+            std::vector<ABFGeoPoint> points = ABFTestRandomPoints(random, count,
+                                                                  std::max(-90.0, center.latitude - spread),
+                                                                  std::min(90.0, center.latitude + spread),
+                                                                  center.longitude - spread * 2,
+                                                                  center.longitude + spread * 2);
+            
+            std::vector<uint8_t> results(count, 2);
+            
+            ABFGeoCircleContainsPoints(center, angularRadius, points.data(), count, results.data());
+            
+            size_t mismatches = 0;
+            
+            for (size_t i = 0; i < count; i++) {
+                double distance = ABFTestAngularDistance(center, points[i]);
+                
+                ABF_CHECK(results[i] <= 1);
+                
+                // Points within a millimeter of the boundary may land on either side
+                if (std::fabs(distance - angularRadius) * ABFTestEarthRadius < 1e-3) {
+                    continue;
+                }
+                
+                mismatches += results[i] != (distance <= angularRadius);
+            }
+            
+            ABF_CHECK(mismatches == 0);
+        }
+    }
+}
+
+static void ABFTestPolygonShapes()
+{
+    // A 10 degree square with a 4 degree hole in the middle
+    std::vector<ABFGeoPoint> vertices = {
+        {0, 0}, {0, 10}, {10, 10}, {10, 0},
+        {3, 3}, {7, 3}, {7, 7}, {3, 7},
+    };
+    
+    size_t squareRing[] = {4};
+    size_t ringCounts[] = {4, 4};
+    
+    ABFGeoPoint points[] = {{5, 5}, {1, 1}, {5, 11}, {-1, 5}, {9, 5}};
+    
+    uint8_t results[5];
+    
+    ABFGeoPolygonContainsPoints(vertices.data(), squareRing, 1, points, 5, results);
+    
+    ABF_CHECK(results[0] == 1 && results[1] == 1 && results[2] == 0 && results[3] == 0 && results[4] == 1);
+    
+    ABFGeoPolygonContainsPoints(vertices.data(), ringCounts, 2, points, 5, results);
+    
+    ABF_CHECK(results[0] == 0 && results[1] == 1 && results[2] == 0 && results[3] == 0 && results[4] == 1);
+    
+    // An empty outer ring contains nothing
+    size_t emptyRing[] = {0};
+    
+    ABFGeoPolygonContainsPoints(vertices.data(), emptyRing, 1, points, 5, results);
+    
+    ABF_CHECK(results[0] == 0 && results[1] == 0 && results[4] == 0);
+    
+    ABFGeoPolygonContainsPoints(vertices.data(), ringCounts, 0, points, 5, results);
+    
+    ABF_CHECK(results[0] == 0 && results[1] == 0 && results[4] == 0);
+}
+
+static void ABFTestPolygonAcrossMeridian()
+{
+    // Unwrapped from 170 to 190, so the points at -175 are wrapped into the frame of the ring
+    std::vector<ABFGeoPoint> vertices = {{-10, 170}, {-10, -170}, {10, -170}, {10, 170}};
+    
+    ABFGeoUnwrapLongitudes(vertices.data(), vertices.size(), vertices[0].longitude);
+    
+    ABF_CHECK(vertices[1].longitude == 190);
+    
+    size_t ringCounts[] = {4};
+    
+    ABFGeoPoint points[] = {{0, -175}, {0, 175}, {0, 180}, {0, -165}, {0, 165}};
+    
+    uint8_t results[5];
+    
+    ABFGeoPolygonContainsPoints(vertices.data(), ringCounts, 1, points, 5, results);
+    
+    ABF_CHECK(results[0] == 1);
+    ABF_CHECK(results[1] == 1);
+    ABF_CHECK(results[2] == 1);
+    ABF_CHECK(results[3] == 0);
+    ABF_CHECK(results[4] == 0);
+}
+
+static void ABFTestPolygonMatchesReference()
+{
+    ABFTestRandom random(42);
+    
+    // A star with a rotated star hole, so edges have every slope
+    std::vector<ABFGeoPoint> outer;
+    std::vector<ABFGeoPoint> hole;
+    
+    for (int i = 0; i < 24; i++) {
+        double angle = i * 2 * M_PI / 24;
+        double outerRadius = i % 2 ? 20 : 8;
+        double holeRadius = i % 2 ? 4 : 1.5;
+        
+        outer.push_back({30 + outerRadius * std::sin(angle), -60 + outerRadius * std::cos(angle)});
+        hole.push_back({30 + holeRadius * std::sin(angle + 0.1), -60 + holeRadius * std::cos(angle + 0.1)});
+    }
+    
+    std::vector<ABFGeoPoint> vertices = outer;
+    vertices.insert(vertices.end(), hole.begin(), hole.end());
+    
+    size_t ringCounts[] = {outer.size(), hole.size()};
+    
+    const size_t counts[] = {1, 256, 257, 513, 20000};
+    
+    for (size_t count : counts) {
+        std::vector<ABFGeoPoint> points = ABFTestRandomPoints(random, count, 5, 55, -85, -35);
+        
+        std::vector<uint8_t> results(count, 2);
+        
+        ABFGeoPolygonContainsPoints(vertices.data(), ringCounts, 2, points.data(), count, results.data());
+        
+        size_t mismatches = 0;
+        
+        for (size_t i = 0; i < count; i++) {
+            bool expected = ABFTestRingContains(outer, points[i]) != ABFTestRingContains(hole, points[i]);
+            
+            mismatches += results[i] != expected;
+        }
+        
+        ABF_CHECK(mismatches == 0);
+    }
+}
+
+static void ABFTestCircleCovering()
+{
+    ABFTestRandom random(44);
+    
+    // Ordinary, at the -180/180 meridian, around and at each pole, and large enough to wrap the globe
+    const ABFGeoPoint centers[] = {{40, -100}, {0, 179.9}, {-30, -180}, {89.9, 10}, {-88, 135}, {90, 0}, {-90, 0}};
+    const double angularRadii[] = {1e-6, 0.01, 0.3, 1.2, 2.5, 3.1, M_PI};
+    const size_t bandCounts[] = {1, 4, 16};
+    
+    for (ABFGeoPoint center : centers) {
+        for (double angularRadius : angularRadii) {
+            // Points in the circle, on its edge and anywhere on the sphere
+            std::vector<ABFGeoPoint> points;
+            
+            for (size_t i = 0; i < 4000; i++) {
+                double bearing = random.uniform(0, 2 * M_PI);
+                double distance = i % 2 ? angularRadius * (1 - 1e-9) : random.uniform(0, angularRadius);
+                
+                points.push_back(ABFTestDestination(center, distance, bearing));
+            }
+            
+            for (size_t i = 0; i < 1000; i++) {
+                points.push_back({std::asin(random.uniform(-1, 1)) * 180 / M_PI, random.uniform(-180, 180)});
+            }
+            
+            std::vector<uint8_t> results(points.size());
+            
+            ABFGeoCircleContainsPoints(center, angularRadius, points.data(), points.size(), results.data());
+            
+            for (size_t bandCount : bandCounts) {
+                std::vector<ABFGeoRegion> regions(bandCount);
+                
+                size_t regionCount = ABFGeoCoveringRegionsForCircle(center, angularRadius, bandCount, regions.data());
+                
+                ABF_CHECK(regionCount == bandCount);
+                
+                regions.resize(regionCount);
+                
+                size_t uncoveredCount = ABFTestUncoveredCount(regions, points, results);
+                
+                if (uncoveredCount > 0) {
+                    std::fprintf(stderr, "circle (%g, %g) radius %g, %zu bands: %zu points not covered\n",
+                                 center.latitude, center.longitude, angularRadius, bandCount, uncoveredCount);
+                }
+                
+                ABF_CHECK(uncoveredCount == 0);
+            }
+        }
+    }
+    
+    // More bands cover less of the sphere than the bounding region
+    ABFGeoPoint center = {50, 20};
+    
+    ABFGeoRegion boundingRegion;
+    ABFGeoRegion bands[8];
+    
+    ABFGeoCoveringRegionsForCircle(center, 0.2, 1, &boundingRegion);
+    ABFGeoCoveringRegionsForCircle(center, 0.2, 8, bands);
+    
+    double bandArea = 0;
+    
+    for (const ABFGeoRegion &band : bands) {
+        bandArea += band.latitudeDelta * band.longitudeDelta;
+    }
+    
+    ABF_CHECK(bandArea < boundingRegion.latitudeDelta * boundingRegion.longitudeDelta);
+}
+
+static void ABFTestPolygonCovering()
+{
+    ABFTestRandom random(45);
+    
+    std::vector<std::vector<ABFGeoPoint>> polygons = {
+        // A concave arrow
+        {{0, 0}, {10, 20}, {0, 40}, {30, 20}},
+        // Across the -180/180 meridian
+        {{-10, 170}, {-10, -170}, {10, -160}, {20, 175}},
+        // Near the north pole
+        {{80, -170}, {80, -10}, {89.5, 100}, {85, 170}},
+        // Large, wider than a hemisphere
+        {{-60, -150}, {-60, 150}, {60, 150}, {0, 0}, {60, -150}},
+    };
+    
+    const size_t bandCounts[] = {1, 4, 16};
+    
+    for (std::vector<ABFGeoPoint> &vertices : polygons) {
+        ABFGeoUnwrapLongitudes(vertices.data(), vertices.size(), vertices[0].longitude);
+        
+        size_t ringCounts[] = {vertices.size()};
+        
+        double minLatitude = 90;
+        double maxLatitude = -90;
+        
+        for (const ABFGeoPoint &vertex : vertices) {
+            minLatitude = std::min(minLatitude, vertex.latitude);
+            maxLatitude = std::max(maxLatitude, vertex.latitude);
+        }
+        
+        // Points over the latitudes of the polygon at every longitude, and on the edges
+        std::vector<ABFGeoPoint> points = ABFTestRandomPoints(random, 20000, minLatitude, maxLatitude, -180, 180);
+        
+        for (size_t i = 0; i < vertices.size(); i++) {
+            ABFGeoPoint start = vertices[i];
+            ABFGeoPoint end = vertices[(i + 1) % vertices.size()];
+            
+            for (int step = 0; step <= 100; step++) {
+                double t = step / 100.0;
+                
+                points.push_back({start.latitude + (end.latitude - start.latitude) * t,
+                                  ABFGeoNormalizedLongitude(start.longitude + (end.longitude - start.longitude) * t)});
+            }
+        }
+        
+        std::vector<uint8_t> results(points.size());
+        
+        ABFGeoPolygonContainsPoints(vertices.data(), ringCounts, 1, points.data(), points.size(), results.data());
+        
+        size_t includedCount = 0;
+        
+        for (uint8_t result : results) {
+            includedCount += result;
+        }
+        
+        ABF_CHECK(includedCount > 0);
+        
+        for (size_t bandCount : bandCounts) {
+            std::vector<ABFGeoRegion> regions(bandCount);
+            
+            size_t regionCount = ABFGeoCoveringRegionsForPolygon(vertices.data(), vertices.size(), bandCount, regions.data());
+            
+            ABF_CHECK(regionCount > 0 && regionCount <= bandCount);
+            
+            regions.resize(regionCount);
+            
+            size_t uncoveredCount = ABFTestUncoveredCount(regions, points, results);
+            
+            if (uncoveredCount > 0) {
+                std::fprintf(stderr, "polygon at (%g, %g), %zu bands: %zu points not covered\n",
+                             vertices[0].latitude, vertices[0].longitude, bandCount, uncoveredCount);
+            }
+            
+            ABF_CHECK(uncoveredCount == 0);
+        }
+    }
+    
+    ABFGeoRegion region;
+    
+    ABF_CHECK(ABFGeoCoveringRegionsForPolygon(nullptr, 0, 4, &region) == 0);
+}
+
+int main()
+{
+    ABFTestNormalizedLongitude();
+    ABFTestUnwrap();
+    ABFTestCircleBoundary();
+    ABFTestCircleAcrossMeridianAndPole();
+    ABFTestCircleMatchesReference();
+    ABFTestPolygonShapes();
+    ABFTestPolygonAcrossMeridian();
+    ABFTestPolygonMatchesReference();
+    ABFTestCircleCovering();
+    ABFTestPolygonCovering();
+    
+    return ABFTestFinish("GeometryKernelsTests");
+}
@@ -0,0 +1,103 @@
+//
+//  HeatMapRasterizerBenchmark.cpp
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#include "ABFHeatMapRasterizer.h"
+#include "ABFTestSupport.h"
+
+#include <cmath>
+
+/**
+ *  Throughput of the heat map core: tiles per second for the vectorized and scalar blur.
+ *
+ *  Usage: HeatMapRasterizerBenchmark [seconds per measurement] [points per tile]
+ */
+
+static const float ABFBenchmarkGradientColors[] = {
+    0, 0, 1, 1,
+    0, 1, 1, 1,
+    0, 1, 0, 1,
+    1, 1, 0, 1,
+    1, 0, 0, 1,
+};
+
+static double ABFBenchmarkTilesPerSecond(uint32_t tilePixels,
+                                         bool useSIMD,
+                                         const std::vector<double> &xs,
+                                         const std::vector<double> &ys,
+                                         double tileMapSize,
+                                         double seconds,
+                                         std::vector<uint32_t> &pixels)
+{
+    ABFHeatMapTileParameters parameters = {tilePixels, 12, 8, useSIMD};
+    
+    std::vector<uint32_t> gradientTable(ABFHeatMapGradientSteps);
+    ABFHeatMapGradientTable(ABFBenchmarkGradientColors, 5, gradientTable.data());
+    
+    double mapPointsPerPixel = tileMapSize / tilePixels;
+    double padding = parameters.radius * mapPointsPerPixel;
+    
+    pixels.assign((size_t)tilePixels * tilePixels, 0);
+    
+    size_t tiles = 0;
+    double start = ABFTestSeconds();
+    double elapsed = 0;
+    
+    do {
+        ABFHeatMapRenderTile(&parameters,
+                             xs.data(),
+                             ys.data(),
+                             xs.size(),
+                             -padding,
+                             -padding,
+                             ABFTestMapSizeWorld,
+                             mapPointsPerPixel,
+                             gradientTable.data(),
+                             pixels.data());
+        tiles++;
+        elapsed = ABFTestSeconds() - start;
+    } while (elapsed < seconds);
+    
+    return tiles / elapsed;
+}
+
+int main(int argc, const char *argv[])
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 1.0;
+    size_t pointCount = argc > 2 ? (size_t)std::atol(argv[2]) : 100000;
+    
+    // A dense city at zoom 12, where a tile is about 10 km across
+    double tileMapSize = ABFTestMapSizeWorld / 4096;
+    
+    ABFTestRandom random(12);
+    std::vector<double> xs(pointCount);
+    std::vector<double> ys(pointCount);
+    
+    for (size_t i = 0; i < pointCount; i++) {
+        xs[i] = random.normal(tileMapSize / 2, tileMapSize / 5);
+        ys[i] = random.normal(tileMapSize / 2, tileMapSize / 5);
+    }
+    
+    std::printf("vectorized blur: %s, %zu points per tile\n", ABFHeatMapSIMDAvailable() ? "yes" : "no (scalar fallback)", pointCount);
+    
+    const uint32_t tileSizes[] = {256, 512};
+    
+    for (uint32_t tilePixels : tileSizes) {
+        std::vector<uint32_t> simdPixels;
+        std::vector<uint32_t> scalarPixels;
+        
+        double simdRate = ABFBenchmarkTilesPerSecond(tilePixels, true, xs, ys, tileMapSize, seconds, simdPixels);
+        double scalarRate = ABFBenchmarkTilesPerSecond(tilePixels, false, xs, ys, tileMapSize, seconds, scalarPixels);
+        
+        std::printf("%4upx tiles: %8.1f tiles/s vectorized, %8.1f tiles/s scalar (%.2fx)\n",
+                    tilePixels, simdRate, scalarRate, simdRate / scalarRate);
+        
+        ABF_CHECK(ABFTestMaxChannelDifference(simdPixels, scalarPixels) <= 1);
+    }
+    
+    return ABFTestFinish("HeatMapRasterizerBenchmark");
+}
@@ -0,0 +1,305 @@
+//
+//  HeatMapRasterizerTests.cpp
+//  ABFRealmMapView
+//
+//  Created by Adam Fish on 10/18/26.
+//  Copyright (c) 2026 Adam Fish. All rights reserved.
+//
+
+#include "ABFHeatMapRasterizer.h"
+#include "ABFTestSupport.h"
+
+#include <cmath>
+#include <cstring>
+
+/**
+ *  Default gradient of ABFHeatMapTileOverlay: blue, cyan, green, yellow, red
+ */
+static const float ABFTestGradientColors[] = {
+    0, 0, 1, 1,
+    0, 1, 1, 1,
+    0, 1, 0, 1,
+    1, 1, 0, 1,
+    1, 0, 0, 1,
+};
+
+struct ABFTestTile {
+    uint32_t z, x, y;
+    uint32_t tilePixels;
+    uint32_t radius;
+    float saturationDensity;
+};
+
+struct ABFTestPoints {
+    std::vector<double> xs;
+    std::vector<double> ys;
+    
+    void add(double x, double y)
+    {
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+};
+
+static double ABFTestTileMapSize(const ABFTestTile &tile)
+{
+    return ABFTestMapSizeWorld / std::pow(2.0, tile.z);
+}
+
+/**
+ *  Renders a tile the way ABFHeatMapTileOverlay does: the density grid starts the blur radius before the tile
+ */
+static size_t ABFTestRenderTile(const ABFTestTile &tile,
+                                const ABFTestPoints &points,
+                                bool useSIMD,
+                                std::vector<uint32_t> &pixels)
+{
+    ABFHeatMapTileParameters parameters = {tile.tilePixels, tile.radius, tile.saturationDensity, useSIMD};
+    
+    std::vector<uint32_t> gradientTable(ABFHeatMapGradientSteps);
+    ABFHeatMapGradientTable(ABFTestGradientColors, 5, gradientTable.data());
+    
+    double tileMapSize = ABFTestTileMapSize(tile);
+    double mapPointsPerPixel = tileMapSize / tile.tilePixels;
+    double padding = tile.radius * mapPointsPerPixel;
+    
+    pixels.assign((size_t)tile.tilePixels * tile.tilePixels, 0);
+    
+    return ABFHeatMapRenderTile(&parameters,
+                                points.xs.data(),
+                                points.ys.data(),
+                                points.xs.size(),
+                                tile.x * tileMapSize - padding,
+                                tile.y * tileMapSize - padding,
+                                ABFTestMapSizeWorld,
+                                mapPointsPerPixel,
+                                gradientTable.data(),
+                                pixels.data());
+}
+
+/**
+ *  Compares a tile with its golden image, or rewrites the golden image when ABF_UPDATE_GOLDEN is set
+ */
+static void ABFTestCheckGolden(const std::string &name,
+                               const ABFTestTile &tile,
+                               const ABFTestPoints &points)
+{
+    std::vector<uint32_t> simdPixels;
+    std::vector<uint32_t> scalarPixels;
+    
+    ABFTestRenderTile(tile, points, true, simdPixels);
+    ABFTestRenderTile(tile, points, false, scalarPixels);
+    
+    // Both blur paths sum in the same order, only fused multiply-adds can move a channel by one
+    ABF_CHECK(ABFTestMaxChannelDifference(simdPixels, scalarPixels) <= 1);
+    
+    std::string path = std::string(ABF_GOLDEN_DIRECTORY) + "/heatmap_" + name + ".pam";
+    
+    if (std::getenv("ABF_UPDATE_GOLDEN")) {
+        ABF_CHECK(ABFTestWritePAM(path, tile.tilePixels, tile.tilePixels, scalarPixels));
+        std::printf("updated %s\n", path.c_str());
+        return;
+    }
+    
+    uint32_t width = 0, height = 0;
+    std::vector<uint32_t> goldenPixels;
+    
+    bool read = ABFTestReadPAM(path, width, height, goldenPixels);
+    
+    ABF_CHECK(read);
+    
+    if (!read) {
+        std::fprintf(stderr, "missing golden image %s, run with ABF_UPDATE_GOLDEN=1 to create it\n", path.c_str());
+        return;
+    }
+    
+    ABF_CHECK(width == tile.tilePixels && height == tile.tilePixels);
+    
+    if (width == tile.tilePixels && height == tile.tilePixels) {
+        // Tolerance for the libm and FMA differences between platforms
+        ABF_CHECK(ABFTestMaxChannelDifference(simdPixels, goldenPixels) <= 1);
+        ABF_CHECK(ABFTestMaxChannelDifference(scalarPixels, goldenPixels) <= 1);
+    }
+}
+
+static void ABFTestGradientTable()
+{
+    std::vector<uint32_t> table(ABFHeatMapGradientSteps);
+    ABFHeatMapGradientTable(ABFTestGradientColors, 5, table.data());
+    
+    const uint8_t *first = (const uint8_t *)&table.front();
+    const uint8_t *last = (const uint8_t *)&table.back();
+    
+    // Transparent for no density, opaque red at saturation
+    ABF_CHECK(first[0] == 0 && first[1] == 0 && first[2] == 0 && first[3] == 0);
+    ABF_CHECK(last[0] == 255 && last[1] == 0 && last[2] == 0 && last[3] == 255);
+    
+    // Premultiplied: no channel exceeds alpha
+    for (uint32_t pixel : table) {
+        const uint8_t *bytes = (const uint8_t *)&pixel;
+        
+        ABF_CHECK(bytes[0] <= bytes[3] && bytes[1] <= bytes[3] && bytes[2] <= bytes[3]);
+    }
+    
+    // No colors gives a transparent table
+    ABFHeatMapGradientTable(ABFTestGradientColors, 0, table.data());
+    
+    for (uint32_t pixel : table) {
+        ABF_CHECK(pixel == 0);
+    }
+}
+
+static void ABFTestBinPoints()
+{
+    const uint32_t gridPixels = 8;
+    std::vector<float> density(gridPixels * gridPixels, 0.0f);
+    
+    double xs[] = {0, 7.5, 8, -0.5, ABFTestMapSizeWorld - 0.5, ABFTestMapSizeWorld + 1.5};
+    double ys[] = {0, 7.5, 0, 0, 1, 2};
+    
+    size_t binned = ABFHeatMapBinPoints(xs, ys, 6, 0, 0, ABFTestMapSizeWorld, 1, gridPixels, density.data());
+    
+    // Outside on the right, and -0.5 wraps to the far side of the world
+    ABF_CHECK(binned == 3);
+    ABF_CHECK(density[0] == 1);
+    ABF_CHECK(density[7 * gridPixels + 7] == 1);
+    ABF_CHECK(density[2 * gridPixels + 1] == 1);
+    
+    // Points across the meridian land in a grid that starts before the world
+    std::fill(density.begin(), density.end(), 0.0f);
+    
+    binned = ABFHeatMapBinPoints(xs, ys, 6, -4, 0, ABFTestMapSizeWorld, 1, gridPixels, density.data());
+    
+    ABF_CHECK(binned == 4);
+    ABF_CHECK(density[0 * gridPixels + 4] == 1);
+    ABF_CHECK(density[0 * gridPixels + 3] == 1);
+    ABF_CHECK(density[1 * gridPixels + 3] == 1);
+    ABF_CHECK(density[2 * gridPixels + 5] == 1);
+}
+
+static void ABFTestEmptyTile()
+{
+    ABFTestTile tile = {10, 512, 340, 64, 12, 8};
+    ABFTestPoints points;
+    
+    // Points far away from the tile
+    points.add(0, 0);
+    points.add(ABFTestMapSizeWorld / 4, ABFTestMapSizeWorld / 4);
+    
+    std::vector<uint32_t> pixels;
+    
+    ABF_CHECK(ABFTestRenderTile(tile, points, true, pixels) == 0);
+    
+    for (uint32_t pixel : pixels) {
+        ABF_CHECK(pixel == 0);
+    }
+}
+
+static void ABFTestSinglePointIsSymmetric()
+{
+    // A low saturation, a lone point is too faint to show at the default
+    ABFTestTile tile = {10, 512, 340, 64, 12, 0.05f};
+    double tileMapSize = ABFTestTileMapSize(tile);
+    double mapPointsPerPixel = tileMapSize / tile.tilePixels;
+    
+    // Center of pixel (32, 32)
+    ABFTestPoints points;
+    points.add(tile.x * tileMapSize + 32.5 * mapPointsPerPixel, tile.y * tileMapSize + 32.5 * mapPointsPerPixel);
+    
+    std::vector<uint32_t> pixels;
+    
+    ABF_CHECK(ABFTestRenderTile(tile, points, true, pixels) == 1);
+    ABF_CHECK(pixels[32 * 64 + 32] != 0);
+    
+    for (int offset = 1; offset <= 12; offset++) {
+        ABF_CHECK(pixels[32 * 64 + 32 - offset] == pixels[32 * 64 + 32 + offset]);
+        ABF_CHECK(pixels[(32 - offset) * 64 + 32] == pixels[(32 + offset) * 64 + 32]);
+        ABF_CHECK(pixels[32 * 64 + 32 + offset] == pixels[(32 + offset) * 64 + 32]);
+    }
+    
+    // Nothing beyond the blur radius
+    ABF_CHECK(pixels[32 * 64 + 32 + 13] == 0);
+    ABF_CHECK(pixels[(32 + 13) * 64 + 32] == 0);
+}
+
+static void ABFTestGoldenCluster()
+{
+    ABFTestTile tile = {10, 512, 340, 64, 12, 8};
+    double tileMapSize = ABFTestTileMapSize(tile);
+    
+    ABFTestRandom random(26);
+    ABFTestPoints points;
+    
+    double centerX = (tile.x + 0.5) * tileMapSize;
+    double centerY = (tile.y + 0.5) * tileMapSize;
+    
+    for (int i = 0; i < 2000; i++) {
+        points.add(random.normal(centerX, tileMapSize / 6), random.normal(centerY, tileMapSize / 6));
+    }
+    
+    // Sparse background, including points just outside the tile that blur into it
+    for (int i = 0; i < 200; i++) {
+        points.add(random.uniform(centerX - tileMapSize, centerX + tileMapSize),
+                   random.uniform(centerY - tileMapSize, centerY + tileMapSize));
+    }
+    
+    ABFTestCheckGolden("cluster", tile, points);
+}
+
+static void ABFTestGoldenAntimeridian()
+{
+    ABFTestTile tile = {3, 0, 3, 64, 12, 8};
+    double tileMapSize = ABFTestTileMapSize(tile);
+    double mapPointsPerPixel = tileMapSize / tile.tilePixels;
+    
+    ABFTestRandom random(180);
+    ABFTestPoints points;
+    
+    double y = (tile.y + 0.5) * tileMapSize;
+    
+    // Points on both sides of the -180/180 meridian, the ones at the far east edge blur into the west edge of the tile
+    for (int i = 0; i < 300; i++) {
+        points.add(random.uniform(0, 6 * mapPointsPerPixel), random.normal(y, 8 * mapPointsPerPixel));
+        points.add(random.uniform(ABFTestMapSizeWorld - 6 * mapPointsPerPixel, ABFTestMapSizeWorld), random.normal(y, 8 * mapPointsPerPixel));
+    }
+    
+    std::vector<uint32_t> pixels;
+    
+    ABFTestRenderTile(tile, points, true, pixels);
+    
+    ABF_CHECK(pixels[32 * 64] != 0);
+    
+    ABFTestCheckGolden("antimeridian", tile, points);
+}
+
+static void ABFTestGoldenUnalignedTile()
+{
+    // A width that is not a multiple of the vector width exercises the scalar tail of the blur
+    ABFTestTile tile = {12, 2048, 1361, 61, 5, 3};
+    double tileMapSize = ABFTestTileMapSize(tile);
+    
+    ABFTestRandom random(61);
+    ABFTestPoints points;
+    
+    for (int i = 0; i < 400; i++) {
+        points.add(random.uniform(tile.x * tileMapSize, (tile.x + 1) * tileMapSize),
+                   random.normal((tile.y + 0.3) * tileMapSize, tileMapSize / 8));
+    }
+    
+    ABFTestCheckGolden("unaligned", tile, points);
+}
+
+int main()
+{
+    std::printf("vectorized blur: %s\n", ABFHeatMapSIMDAvailable() ? "yes" : "no (scalar fallback)");
+    
+    ABFTestGradientTable();
+    ABFTestBinPoints();
+    ABFTestEmptyTile();
+    ABFTestSinglePointIsSymmetric();
+    ABFTestGoldenCluster();
+    ABFTestGoldenAntimeridian();
+    ABFTestGoldenUnalignedTile();
+    
+    return ABFTestFinish("HeatMapRasterizerTests");
+}